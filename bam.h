@@ -0,0 +1,59 @@
+/**
+ * @file bam.h
+ * @brief Fixed-point 32-bit binary angles (BAM) for ecliptic longitudes.
+ *
+ * A full turn maps onto the whole uint32_t range, so 0x00000000 is 0 degrees,
+ * 0x80000000 is 180 degrees and wrap-around at 360 degrees is plain unsigned
+ * overflow. Adding, subtracting and folding angles needs no range fix-ups,
+ * and the zodiac sign is a single multiply and shift. One unit is roughly
+ * 8.4e-8 degrees, far finer than any ephemeris we consume.
+ *
+ * BAM is the storage format for longitude arrays; the double-degree helpers
+ * exist for parsing and presentation only.
+ */
+
+#ifndef BAM_H
+#define BAM_H
+
+#include <stdint.h>
+#include <math.h>
+
+typedef uint32_t bam32_t;
+
+#define BAM_UNITS_PER_DEG (4294967296.0 / 360.0)
+
+// Compile-time conversion for constant angles in [0, 360), e.g. BAM_DEG(120).
+#define BAM_DEG(deg) ((bam32_t)((deg) * BAM_UNITS_PER_DEG + 0.5))
+
+#define BAM_180 ((bam32_t)0x80000000u)
+
+// Converts degrees (any range, negative included) to a binary angle.
+static inline bam32_t bam_from_deg(double degrees) {
+    // The int64_t -> uint32_t conversion is modular, which performs the 360 degree wrap.
+    return (bam32_t)llrint(fmod(degrees, 360.0) * BAM_UNITS_PER_DEG);
+}
+
+// Converts a binary angle to degrees in [0, 360).
+static inline double bam_to_deg(bam32_t a) {
+    return a * (360.0 / 4294967296.0);
+}
+
+// Signed difference a - b as a fraction of a turn in [-180, 180) degrees, in BAM units.
+static inline int32_t bam_diff(bam32_t a, bam32_t b) {
+    uint32_t d = a - b;
+    return (d & BAM_180) ? -(int32_t)(~d) - 1 : (int32_t)d;
+}
+
+// Unsigned separation between two angles folded to [0, 180] degrees, without branches.
+static inline bam32_t bam_sep(bam32_t a, bam32_t b) {
+    uint32_t d = a - b;
+    uint32_t m = -(d >> 31); // all ones when the difference exceeds half a turn
+    return (d ^ m) - m;
+}
+
+// Zodiac sign index 0-11; exact floor(degrees / 30) without a division.
+static inline int bam_sign_index(bam32_t a) {
+    return (int)(((uint64_t)a * 12u) >> 32);
+}
+
+#endif // BAM_H
@@ -0,0 +1,152 @@
+/**
+ * @file bioindex.c
+ * @brief Population biorhythm index; see bioindex.h.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "biorhythm.h"
+#include "bioindex.h"
+
+static const int periods[3] = { BIO_PHYSICAL_DAYS, BIO_EMOTIONAL_DAYS, BIO_INTELLECTUAL_DAYS };
+
+// CRT basis: crt_basis[c] is 1 modulo periods[c] and 0 modulo the other two.
+static const long crt_basis[3] = {
+    21252L / 23 * 6,   // (924 * 6) mod 23 == 1
+    21252L / 28 * 19,  // (759 * 19) mod 28 == 1
+    21252L / 33 * 2    // (644 * 2) mod 33 == 1
+};
+
+static inline long mod(long a, long m) {
+    long r = a % m;
+    return r < 0 ? r + m : r;
+}
+
+void bio_predicate_any(struct BioPredicate *pred) {
+    for (int c = 0; c < 3; c++) pred->phases[c] = (UINT64_C(1) << periods[c]) - 1;
+}
+
+void bio_predicate_require(struct BioPredicate *pred, int cycle, enum BioLevel level) {
+    uint64_t mask = 0;
+    for (int k = 0; k < periods[cycle]; k++) {
+        struct Biorhythm bio;
+        biorhythm_lookup(k, &bio);
+        double value = cycle == 0 ? bio.physical : cycle == 1 ? bio.emotional : bio.intellectual;
+        int match;
+        switch (level) {
+        case BIO_LEVEL_HIGH: match = value > 50; break;
+        case BIO_LEVEL_LOW: match = value < -50; break;
+        default: match = k == 0 || k == periods[cycle] / 2; break; // Same days biorhythm_calendar() reports
+        }
+        if (match) mask |= UINT64_C(1) << k;
+    }
+    pred->phases[cycle] &= mask;
+}
+
+int bio_index_build(struct BioIndex *ix, const long *birth_days, size_t n, long today) {
+    memset(ix, 0, sizeof(*ix));
+    ix->num_users = n;
+    ix->today = today;
+    ix->offsets = calloc(BIO_SUPER_CYCLE_DAYS + 1, sizeof(*ix->offsets));
+    ix->users = malloc((n ? n : 1) * sizeof(*ix->users));
+    if (!ix->offsets || !ix->users) {
+        bio_index_free(ix);
+        return -1;
+    }
+
+    // Counting sort by residue: histogram, prefix sum, scatter.
+    for (size_t i = 0; i < n; i++) ix->offsets[mod(birth_days[i], BIO_SUPER_CYCLE_DAYS) + 1]++;
+    for (int s = 0; s < BIO_SUPER_CYCLE_DAYS; s++) ix->offsets[s + 1] += ix->offsets[s];
+    uint32_t *fill = malloc(BIO_SUPER_CYCLE_DAYS * sizeof(*fill));
+    if (!fill) {
+        bio_index_free(ix);
+        return -1;
+    }
+    memcpy(fill, ix->offsets, BIO_SUPER_CYCLE_DAYS * sizeof(*fill));
+    for (size_t i = 0; i < n; i++) ix->users[fill[mod(birth_days[i], BIO_SUPER_CYCLE_DAYS)]++] = (uint32_t)i;
+    free(fill);
+    return 0;
+}
+
+void bio_index_free(struct BioIndex *ix) {
+    free(ix->offsets);
+    free(ix->users);
+    memset(ix, 0, sizeof(*ix));
+}
+
+void bio_index_advance(struct BioIndex *ix, long days) {
+    ix->today += days;
+}
+
+size_t bio_index_query(const struct BioIndex *ix, const struct BioPredicate *pred, uint32_t *out, size_t max_out) {
+    // A user at phase k has birth_day == today - k in that cycle.
+    long base[3];
+    for (int c = 0; c < 3; c++) base[c] = mod(ix->today, periods[c]);
+
+    size_t total = 0;
+    for (int p0 = 0; p0 < periods[0]; p0++) {
+        if (!(pred->phases[0] >> p0 & 1)) continue;
+        long r0 = mod(base[0] - p0, periods[0]) * crt_basis[0];
+        for (int p1 = 0; p1 < periods[1]; p1++) {
+            if (!(pred->phases[1] >> p1 & 1)) continue;
+            long r1 = r0 + mod(base[1] - p1, periods[1]) * crt_basis[1];
+            for (int p2 = 0; p2 < periods[2]; p2++) {
+                if (!(pred->phases[2] >> p2 & 1)) continue;
+                long s = (r1 + mod(base[2] - p2, periods[2]) * crt_basis[2]) % BIO_SUPER_CYCLE_DAYS;
+                uint32_t begin = ix->offsets[s], end = ix->offsets[s + 1];
+                if (out && total < max_out) {
+                    size_t take = end - begin;
+                    if (take > max_out - total) take = max_out - total;
+                    memcpy(out + total, ix->users + begin, take * sizeof(*out));
+                }
+                total += end - begin;
+            }
+        }
+    }
+    return total;
+}
+
+void bio_index_compat_one(const struct BioIndex *ix, long birth_day, double *scores) {
+    long residue = mod(birth_day, BIO_SUPER_CYCLE_DAYS);
+    for (long s = 0; s < BIO_SUPER_CYCLE_DAYS; s++) {
+        uint32_t begin = ix->offsets[s], end = ix->offsets[s + 1];
+        if (begin == end) continue;
+        double score = biorhythm_compatibility(residue - s);
+        for (uint32_t i = begin; i < end; i++) scores[ix->users[i]] = score;
+    }
+}
+
+int bio_index_compat_pairs(const struct BioIndex *ix, uint64_t hist[201]) {
+    memset(hist, 0, 201 * sizeof(hist[0]));
+
+    // Collect the occupied buckets once so the pair loop skips empty residues.
+    long *residues = malloc(BIO_SUPER_CYCLE_DAYS * sizeof(*residues));
+    uint64_t *sizes = malloc(BIO_SUPER_CYCLE_DAYS * sizeof(*sizes));
+    if (!residues || !sizes) {
+        free(residues);
+        free(sizes);
+        return -1;
+    }
+    int occupied = 0;
+    for (long s = 0; s < BIO_SUPER_CYCLE_DAYS; s++) {
+        uint64_t size = ix->offsets[s + 1] - ix->offsets[s];
+        if (size) {
+            residues[occupied] = s;
+            sizes[occupied++] = size;
+        }
+    }
+
+    for (int a = 0; a < occupied; a++) {
+        // Pairs inside one bucket share every phase.
+        hist[200] += sizes[a] * (sizes[a] - 1) / 2;
+        for (int b = a + 1; b < occupied; b++) {
+            long score = lrint(biorhythm_compatibility(residues[a] - residues[b]));
+            hist[score + 100] += sizes[a] * sizes[b];
+        }
+    }
+    free(residues);
+    free(sizes);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file bioindex.h
+ * @brief Inverted index answering biorhythm predicates over a user population.
+ *
+ * A user's phase in each cycle is (today - birth_day) mod period. Since the
+ * 23, 28 and 33 day periods are pairwise coprime, the birth day modulo their
+ * LCM (21,252) fixes all three phases at once. Users are bucketed by that
+ * residue once; a daily query maps the wanted phases back to residues via the
+ * Chinese remainder theorem and concatenates the matching buckets. Moving to
+ * another day only changes the day the residues are interpreted against.
+ */
+
+#ifndef BIOINDEX_H
+#define BIOINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum BioLevel {
+    BIO_LEVEL_HIGH,     // Above +50%
+    BIO_LEVEL_LOW,      // Below -50%
+    BIO_LEVEL_CRITICAL  // A zero crossing falls on the day
+};
+
+// Bit k of phases[c] is set when phase k of cycle c (physical, emotional,
+// intellectual) satisfies the predicate.
+struct BioPredicate {
+    uint64_t phases[3];
+};
+
+struct BioIndex {
+    size_t num_users;
+    long today;         // Day number the residues are currently read against
+    uint32_t *offsets;  // BIO_SUPER_CYCLE_DAYS + 1 bucket boundaries into users
+    uint32_t *users;    // User indices grouped by birth-day residue
+};
+
+// Starts a predicate that matches every phase of every cycle.
+void bio_predicate_any(struct BioPredicate *pred);
+
+// Narrows one cycle (0 physical, 1 emotional, 2 intellectual) to a level.
+void bio_predicate_require(struct BioPredicate *pred, int cycle, enum BioLevel level);
+
+// Buckets n users by birth day number. Requires biorhythm_init(). Returns 0 on success, -1 on failure.
+int bio_index_build(struct BioIndex *ix, const long *birth_days, size_t n, long today);
+void bio_index_free(struct BioIndex *ix);
+
+// Re-targets the index at a later (or earlier) day without touching any bucket.
+void bio_index_advance(struct BioIndex *ix, long days);
+
+// Writes up to max_out matching user indices to out (which may be NULL) and
+// returns the total number of matches.
+size_t bio_index_query(const struct BioIndex *ix, const struct BioPredicate *pred, uint32_t *out, size_t max_out);
+
+// Compatibility of one birth day with every indexed user. Scores depend only
+// on the residue difference, so each occupied bucket is scored once and the
+// value is copied to its users: scores[user] for all num_users users.
+void bio_index_compat_one(const struct BioIndex *ix, long birth_day, double *scores);
+
+// Histogram of compatibility over all unordered user pairs in the index,
+// hist[score + 100] for scores rounded to whole percent. Work is quadratic in
+// occupied buckets (at most 21,252), not in users. Returns 0 on success, -1 on failure.
+int bio_index_compat_pairs(const struct BioIndex *ix, uint64_t hist[201]);
+
+#endif // BIOINDEX_H
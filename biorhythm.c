@@ -0,0 +1,193 @@
+/**
+ * @file biorhythm.c
+ * @brief Biorhythm phase tables and evaluation; see biorhythm.h.
+ */
+
+#include <math.h>
+#include <stddef.h>
+
+#include "biorhythm.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BIO_RESEED_DAYS 256
+
+static double physical_table[BIO_PHYSICAL_DAYS];
+static double emotional_table[BIO_EMOTIONAL_DAYS];
+static double intellectual_table[BIO_INTELLECTUAL_DAYS];
+
+// Cosine of each phase, i.e. how closely two people that many days apart are in step.
+static double physical_alignment[BIO_PHYSICAL_DAYS];
+static double emotional_alignment[BIO_EMOTIONAL_DAYS];
+static double intellectual_alignment[BIO_INTELLECTUAL_DAYS];
+
+// Rounded copies of the tables for compact series output.
+static int8_t physical_samples[BIO_PHYSICAL_DAYS];
+static int8_t emotional_samples[BIO_EMOTIONAL_DAYS];
+static int8_t intellectual_samples[BIO_INTELLECTUAL_DAYS];
+
+static void fill_cycle(double *table, int8_t *samples, double *alignment, int period) {
+    for (int i = 0; i < period; i++) {
+        table[i] = sin(2 * M_PI * i / period) * 100;
+        samples[i] = (int8_t)lrint(table[i]);
+        alignment[i] = cos(2 * M_PI * i / period) * 100;
+    }
+}
+
+void biorhythm_init(void) {
+    fill_cycle(physical_table, physical_samples, physical_alignment, BIO_PHYSICAL_DAYS);
+    fill_cycle(emotional_table, emotional_samples, emotional_alignment, BIO_EMOTIONAL_DAYS);
+    fill_cycle(intellectual_table, intellectual_samples, intellectual_alignment, BIO_INTELLECTUAL_DAYS);
+}
+
+// Phase index of a day count within a cycle; also correct for days before birth.
+static inline int cycle_phase(long days, int period) {
+    long r = days % period;
+    return (int)(r < 0 ? r + period : r);
+}
+
+void biorhythm_lookup(long days_alive, struct Biorhythm *out) {
+    out->physical = physical_table[cycle_phase(days_alive, BIO_PHYSICAL_DAYS)];
+    out->emotional = emotional_table[cycle_phase(days_alive, BIO_EMOTIONAL_DAYS)];
+    out->intellectual = intellectual_table[cycle_phase(days_alive, BIO_INTELLECTUAL_DAYS)];
+}
+
+void biorhythm_alignment(long days_apart, struct Biorhythm *out) {
+    out->physical = physical_alignment[cycle_phase(days_apart, BIO_PHYSICAL_DAYS)];
+    out->emotional = emotional_alignment[cycle_phase(days_apart, BIO_EMOTIONAL_DAYS)];
+    out->intellectual = intellectual_alignment[cycle_phase(days_apart, BIO_INTELLECTUAL_DAYS)];
+}
+
+double biorhythm_compatibility(long days_apart) {
+    struct Biorhythm a;
+    biorhythm_alignment(days_apart, &a);
+    return (a.physical + a.emotional + a.intellectual) / 3;
+}
+
+void biorhythm_exact(double days_alive, struct Biorhythm *out) {
+    out->physical = sin(2 * M_PI * days_alive / BIO_PHYSICAL_DAYS) * 100;
+    out->emotional = sin(2 * M_PI * days_alive / BIO_EMOTIONAL_DAYS) * 100;
+    out->intellectual = sin(2 * M_PI * days_alive / BIO_INTELLECTUAL_DAYS) * 100;
+}
+
+void biorhythm_series(long first_day_alive, int num_days, struct BiorhythmSample *out) {
+    int p = cycle_phase(first_day_alive, BIO_PHYSICAL_DAYS);
+    int e = cycle_phase(first_day_alive, BIO_EMOTIONAL_DAYS);
+    int i = cycle_phase(first_day_alive, BIO_INTELLECTUAL_DAYS);
+
+    for (int d = 0; d < num_days; d++) {
+        out[d].physical = physical_samples[p];
+        out[d].emotional = emotional_samples[e];
+        out[d].intellectual = intellectual_samples[i];
+        if (++p == BIO_PHYSICAL_DAYS) p = 0;
+        if (++e == BIO_EMOTIONAL_DAYS) e = 0;
+        if (++i == BIO_INTELLECTUAL_DAYS) i = 0;
+    }
+}
+
+void biorhythm_series_exact(double first_day_alive, int num_days, struct BiorhythmSample *out) {
+    static const int periods[3] = { BIO_PHYSICAL_DAYS, BIO_EMOTIONAL_DAYS, BIO_INTELLECTUAL_DAYS };
+    double step_cos[3], step_sin[3], re[3] = {0}, im[3] = {0};
+
+    for (int c = 0; c < 3; c++) {
+        step_cos[c] = cos(2 * M_PI / periods[c]);
+        step_sin[c] = sin(2 * M_PI / periods[c]);
+    }
+
+    for (int d = 0; d < num_days; d++) {
+        if (d % BIO_RESEED_DAYS == 0) {
+            for (int c = 0; c < 3; c++) {
+                double angle = 2 * M_PI * (first_day_alive + d) / periods[c];
+                re[c] = cos(angle);
+                im[c] = sin(angle);
+            }
+        }
+        out[d].physical = (int8_t)lrint(im[0] * 100);
+        out[d].emotional = (int8_t)lrint(im[1] * 100);
+        out[d].intellectual = (int8_t)lrint(im[2] * 100);
+        for (int c = 0; c < 3; c++) {
+            double next_re = re[c] * step_cos[c] - im[c] * step_sin[c];
+            im[c] = re[c] * step_sin[c] + im[c] * step_cos[c];
+            re[c] = next_re;
+        }
+    }
+}
+
+void biorhythm_series_batch(const long *first_days_alive, int num_users, int num_days,
+                            struct BiorhythmSample *out) {
+    for (int u = 0; u < num_users; u++) {
+        biorhythm_series(first_days_alive[u], num_days, out + (size_t)u * num_days);
+    }
+}
+
+int biorhythm_calendar_capacity(long first_day, long last_day) {
+    if (last_day < first_day) return 0;
+    long days = last_day - first_day + 1;
+    // Four events per period for each cycle plus one boundary each, and at most
+    // one multi-cycle event for every critical day of the shortest cycle.
+    long events = 4 * days / BIO_PHYSICAL_DAYS + 4 * days / BIO_EMOTIONAL_DAYS
+                + 4 * days / BIO_INTELLECTUAL_DAYS + 3 + 2 * days / BIO_PHYSICAL_DAYS + 1;
+    return (int)events;
+}
+
+// Floor division for possibly negative numerators.
+static inline long floor_div(long a, long b) {
+    long q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+int biorhythm_calendar(long first_day, long last_day, struct BiorhythmEvent *out, int max_events) {
+    static const int periods[3] = { BIO_PHYSICAL_DAYS, BIO_EMOTIONAL_DAYS, BIO_INTELLECTUAL_DAYS };
+
+    // Event j of a cycle sits at exactly j * period / 4 days; kind is j mod 4.
+    // Start each cursor at the first j whose day is not before first_day.
+    long next_j[3];
+    for (int c = 0; c < 3; c++) {
+        next_j[c] = floor_div(4 * first_day + periods[c] - 1, periods[c]);
+    }
+
+    int count = 0;
+    long group_day = 0;
+    int group_critical = 0;
+    for (;;) {
+        // Pick the earliest pending event; ties go to the lower cycle index.
+        int c_min = -1;
+        long day_min = 0;
+        for (int c = 0; c < 3; c++) {
+            long day = floor_div(next_j[c] * periods[c], 4);
+            if (day <= last_day && (c_min < 0 || day < day_min)) {
+                c_min = c;
+                day_min = day;
+            }
+        }
+
+        // Close the previous day's group before moving on.
+        if (group_critical && (c_min < 0 || day_min != group_day)) {
+            if ((group_critical & (group_critical - 1)) && count < max_events) {
+                out[count].day = group_day;
+                out[count].exact = (double)group_day;
+                out[count].cycles = group_critical;
+                out[count].kind = BIO_EVENT_MULTI_CRITICAL;
+                count++;
+            }
+            group_critical = 0;
+        }
+        if (c_min < 0 || count >= max_events) break;
+
+        long j = next_j[c_min]++;
+        enum BiorhythmEventKind kind = (enum BiorhythmEventKind)(j & 3);
+        out[count].day = day_min;
+        out[count].exact = j * periods[c_min] / 4.0;
+        out[count].cycles = 1 << c_min;
+        out[count].kind = kind;
+        count++;
+
+        if (kind == BIO_EVENT_CRITICAL_RISING || kind == BIO_EVENT_CRITICAL_FALLING) {
+            group_day = day_min;
+            group_critical |= 1 << c_min;
+        }
+    }
+    return count;
+}
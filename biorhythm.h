@@ -0,0 +1,98 @@
+/**
+ * @file biorhythm.h
+ * @brief Biorhythm cycle values from days alive.
+ *
+ * The physical (23 day), emotional (28 day) and intellectual (33 day) cycles
+ * are pure sines of days alive, so on whole days each one repeats through a
+ * fixed set of phases and the three together repeat every 21,252 days (their
+ * LCM). Whole-day values come from a 23 + 28 + 33 entry table; a fractional
+ * day count, e.g. from a known birth time, takes the exact sin() path.
+ */
+
+#ifndef BIORHYTHM_H
+#define BIORHYTHM_H
+
+#include <stdint.h>
+
+#define BIO_PHYSICAL_DAYS     23
+#define BIO_EMOTIONAL_DAYS    28
+#define BIO_INTELLECTUAL_DAYS 33
+#define BIO_SUPER_CYCLE_DAYS  21252 // LCM of the three cycle lengths
+
+// Cycle values as percentages in [-100, 100].
+struct Biorhythm {
+    double physical;
+    double emotional;
+    double intellectual;
+};
+
+// Compact per-day record for series output: rounded percentages, 3 bytes per day.
+// Series files are a raw array of these, user-major then day-major.
+struct BiorhythmSample {
+    int8_t physical;
+    int8_t emotional;
+    int8_t intellectual;
+};
+
+// Cycle bits for struct BiorhythmEvent.cycles.
+#define BIO_CYCLE_PHYSICAL     0x1
+#define BIO_CYCLE_EMOTIONAL    0x2
+#define BIO_CYCLE_INTELLECTUAL 0x4
+
+enum BiorhythmEventKind {
+    BIO_EVENT_CRITICAL_RISING,  // Zero crossing into the positive half
+    BIO_EVENT_PEAK,
+    BIO_EVENT_CRITICAL_FALLING, // Zero crossing into the negative half
+    BIO_EVENT_TROUGH,
+    BIO_EVENT_MULTI_CRITICAL    // Two or three cycles are critical on the same day
+};
+
+// A calendar event. Events of one cycle fall every quarter period, so exact
+// is always a multiple of period / 4 and day is its integer part.
+struct BiorhythmEvent {
+    long day;       // Days alive on which the event falls
+    double exact;   // Exact days alive of the event
+    int cycles;     // BIO_CYCLE_* bit(s)
+    enum BiorhythmEventKind kind;
+};
+
+// Fills the phase tables. Call once before any biorhythm_lookup().
+void biorhythm_init(void);
+
+// Biorhythm for a whole number of days alive, by table lookup.
+void biorhythm_lookup(long days_alive, struct Biorhythm *out);
+
+// Phase alignment per cycle of two people born days_apart days apart, as
+// cos(2 * pi * days_apart / period) in percent: 100 means the cycles move in
+// step for life, -100 means they are exactly opposed. Table lookup.
+void biorhythm_alignment(long days_apart, struct Biorhythm *out);
+
+// Overall compatibility score in [-100, 100]: the mean of the three alignments.
+double biorhythm_compatibility(long days_apart);
+
+// Biorhythm for a fractional number of days alive, evaluated with sin().
+void biorhythm_exact(double days_alive, struct Biorhythm *out);
+
+// Fills out[0..num_days) for consecutive whole days starting at first_day_alive.
+// Walks the phase tables, so the cost is a load and store per value.
+void biorhythm_series(long first_day_alive, int num_days, struct BiorhythmSample *out);
+
+// As biorhythm_series() for a fractional starting day count. Each cycle is
+// advanced by a complex rotation per day, reseeded with sin()/cos() every
+// 256 days to keep rounding drift far below one percent.
+void biorhythm_series_exact(double first_day_alive, int num_days, struct BiorhythmSample *out);
+
+// Runs biorhythm_series() for num_users users; out holds num_users * num_days samples.
+void biorhythm_series_batch(const long *first_days_alive, int num_users, int num_days,
+                            struct BiorhythmSample *out);
+
+// Upper bound on the events biorhythm_calendar() can produce for a range.
+int biorhythm_calendar_capacity(long first_day, long last_day);
+
+// Lists the critical days, peaks, troughs and multi-cycle critical days whose
+// day falls in [first_day, last_day] (days alive, inclusive), ordered by day
+// and then cycle. Works directly from the event progressions, so the cost is
+// proportional to the number of events, not days. Returns the event count.
+int biorhythm_calendar(long first_day, long last_day, struct BiorhythmEvent *out, int max_events);
+
+#endif // BIORHYTHM_H
@@ -0,0 +1,181 @@
+/**
+ * @file colexport.c
+ * @brief Columnar export writer; see colexport.h for the file format.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "colexport.h"
+
+enum {
+    BLOCK_END, BLOCK_DICTIONARY, BLOCK_SCHEMA, BLOCK_BATCH
+};
+
+static const size_t column_width[] = { 1, 4, 4, 4 }; // Indexed by enum ColumnType
+
+static size_t pad8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+// Little-endian encoders; the writer does not assume the host byte order.
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void write_bytes(struct ColumnFile *cf, const void *data, size_t n) {
+    if (n && fwrite(data, 1, n, cf->f) != n) cf->failed = 1;
+}
+
+static void write_padding(struct ColumnFile *cf, size_t n) {
+    static const unsigned char zeros[8];
+    write_bytes(cf, zeros, pad8(n) - n);
+}
+
+static void write_block_header(struct ColumnFile *cf, uint32_t kind, uint64_t body_len) {
+    unsigned char header[16];
+    put_u32(header, kind);
+    put_u32(header + 4, 0);
+    put_u32(header + 8, (uint32_t)body_len);
+    put_u32(header + 12, (uint32_t)(body_len >> 32));
+    write_bytes(cf, header, sizeof(header));
+}
+
+// Appends a u16 length-prefixed string to p and returns the bytes used.
+static size_t put_name(unsigned char *p, const char *s) {
+    size_t n = strlen(s);
+    if (n > 0xffff) n = 0xffff;
+    put_u16(p, (uint16_t)n);
+    memcpy(p + 2, s, n);
+    return 2 + n;
+}
+
+int colfile_open(struct ColumnFile *cf, FILE *f) {
+    cf->f = f;
+    cf->failed = 0;
+    cf->next_table_id = 0;
+    write_bytes(cf, "NAXCOL1", 8); // Includes the terminating NUL
+    return cf->failed ? -1 : 0;
+}
+
+void colfile_dictionary(struct ColumnFile *cf, int dict_id, const char *const entries[], int count) {
+    size_t len = 8;
+    for (int i = 0; i < count; i++) len += 2 + strlen(entries[i]);
+    unsigned char *body = malloc(len);
+    if (!body) {
+        cf->failed = 1;
+        return;
+    }
+    put_u32(body, (uint32_t)dict_id);
+    put_u32(body + 4, (uint32_t)count);
+    size_t pos = 8;
+    for (int i = 0; i < count; i++) pos += put_name(body + pos, entries[i]);
+
+    write_block_header(cf, BLOCK_DICTIONARY, pos);
+    write_bytes(cf, body, pos);
+    write_padding(cf, pos);
+    free(body);
+}
+
+int coltable_init(struct ColumnTable *t, struct ColumnFile *cf, const char *name,
+                  const struct ColumnSpec columns[], int num_columns, size_t batch_rows) {
+    t->file = cf;
+    t->id = cf->next_table_id++;
+    t->num_columns = num_columns;
+    t->columns = columns;
+    t->batch_rows = batch_rows;
+    t->rows = 0;
+    t->buffers = calloc(num_columns, sizeof(*t->buffers));
+    if (!t->buffers) return -1;
+    for (int c = 0; c < num_columns; c++) {
+        t->buffers[c] = malloc(batch_rows * column_width[columns[c].type]);
+        if (!t->buffers[c]) {
+            coltable_finish(t);
+            return -1;
+        }
+    }
+
+    // --- Schema Block ---
+    size_t len = 10 + strlen(name);
+    for (int c = 0; c < num_columns; c++) len += 6 + strlen(columns[c].name);
+    unsigned char *body = malloc(len);
+    if (!body) {
+        coltable_finish(t);
+        return -1;
+    }
+    put_u32(body, t->id);
+    put_u32(body + 4, (uint32_t)num_columns);
+    size_t pos = 8 + put_name(body + 8, name);
+    for (int c = 0; c < num_columns; c++) {
+        body[pos] = (unsigned char)columns[c].type;
+        body[pos + 1] = 0;
+        put_u16(body + pos + 2, (uint16_t)(int16_t)columns[c].dict_id);
+        pos += 4 + put_name(body + pos + 4, columns[c].name);
+    }
+    write_block_header(cf, BLOCK_SCHEMA, pos);
+    write_bytes(cf, body, pos);
+    write_padding(cf, pos);
+    free(body);
+    return cf->failed ? -1 : 0;
+}
+
+void coltable_u8(struct ColumnTable *t, int col, uint8_t v) {
+    t->buffers[col][t->rows] = v;
+}
+
+void coltable_i32(struct ColumnTable *t, int col, int32_t v) {
+    put_u32(t->buffers[col] + 4 * t->rows, (uint32_t)v);
+}
+
+void coltable_u32(struct ColumnTable *t, int col, uint32_t v) {
+    put_u32(t->buffers[col] + 4 * t->rows, v);
+}
+
+void coltable_f32(struct ColumnTable *t, int col, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(t->buffers[col] + 4 * t->rows, bits);
+}
+
+static void write_batch(struct ColumnTable *t) {
+    struct ColumnFile *cf = t->file;
+    size_t len = 8;
+    for (int c = 0; c < t->num_columns; c++) len += pad8(t->rows * column_width[t->columns[c].type]);
+
+    unsigned char head[8];
+    put_u32(head, t->id);
+    put_u32(head + 4, (uint32_t)t->rows);
+    write_block_header(cf, BLOCK_BATCH, len);
+    write_bytes(cf, head, sizeof(head));
+    for (int c = 0; c < t->num_columns; c++) {
+        size_t n = t->rows * column_width[t->columns[c].type];
+        write_bytes(cf, t->buffers[c], n);
+        write_padding(cf, n);
+    }
+    t->rows = 0;
+}
+
+void coltable_end_row(struct ColumnTable *t) {
+    if (++t->rows == t->batch_rows) write_batch(t);
+}
+
+void coltable_finish(struct ColumnTable *t) {
+    if (t->rows) write_batch(t);
+    if (t->buffers) {
+        for (int c = 0; c < t->num_columns; c++) free(t->buffers[c]);
+    }
+    free(t->buffers);
+    t->buffers = NULL;
+}
+
+int colfile_close(struct ColumnFile *cf) {
+    write_block_header(cf, BLOCK_END, 0);
+    if (fflush(cf->f) != 0) cf->failed = 1;
+    cf->f = NULL;
+    return cf->failed ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file colexport.h
+ * @brief Streaming columnar export in a small, documented binary format.
+ *
+ * The layout borrows Arrow IPC's ideas (typed column buffers, dictionary
+ * encoded enums, a stream of record batches) without its flatbuffer
+ * metadata, so it can be read with a few lines of code in any language.
+ *
+ * All integers are little-endian. The file is an 8-byte magic "NAXCOL1\0"
+ * followed by blocks, each 8-byte aligned:
+ *
+ *   u32 kind, u32 reserved (0), u64 body_len, body[body_len], zero padding
+ *   to a multiple of 8.
+ *
+ * Block kinds and bodies:
+ *   1 DICTIONARY  u32 dict_id, u32 count, then count x (u16 len, bytes).
+ *   2 SCHEMA      u32 table_id, u32 num_columns, u16 name_len, name, then per
+ *                 column: u8 type, u8 pad, i16 dict_id (-1 if none),
+ *                 u16 name_len, name.
+ *   3 BATCH       u32 table_id, u32 rows, then for each column in schema
+ *                 order rows x width bytes, zero padded to a multiple of 8.
+ *   0 END         Empty body; the last block.
+ *
+ * Column types: 0 u8, 1 i32, 2 u32, 3 f32. A u8 column with a dict_id holds
+ * indices into that dictionary; 255 marks a missing value. Batches hold at
+ * most the table's batch size in rows, so writing needs memory for one batch
+ * per table regardless of the total row count.
+ */
+
+#ifndef COLEXPORT_H
+#define COLEXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define COL_NULL_U8 255
+
+enum ColumnType {
+    COL_U8, COL_I32, COL_U32, COL_F32
+};
+
+struct ColumnSpec {
+    const char *name;
+    enum ColumnType type;
+    int dict_id; // -1 when the column is not dictionary encoded
+};
+
+struct ColumnFile {
+    FILE *f;
+    int failed;
+    uint32_t next_table_id;
+};
+
+struct ColumnTable {
+    struct ColumnFile *file;
+    uint32_t id;
+    int num_columns;
+    const struct ColumnSpec *columns;
+    size_t batch_rows;
+    size_t rows;            // Rows in the current, unwritten batch
+    unsigned char **buffers; // One per column, batch_rows x width bytes
+};
+
+// Starts a file on an open stream by writing the magic. Returns 0 on success, -1 on failure.
+int colfile_open(struct ColumnFile *cf, FILE *f);
+
+// Writes a dictionary block for enum values 0..count-1.
+void colfile_dictionary(struct ColumnFile *cf, int dict_id, const char *const entries[], int count);
+
+// Declares a table and writes its schema. Returns 0 on success, -1 on failure.
+int coltable_init(struct ColumnTable *t, struct ColumnFile *cf, const char *name,
+                  const struct ColumnSpec columns[], int num_columns, size_t batch_rows);
+
+// Cell setters for the current row; call coltable_end_row once all are set.
+void coltable_u8(struct ColumnTable *t, int col, uint8_t v);
+void coltable_i32(struct ColumnTable *t, int col, int32_t v);
+void coltable_u32(struct ColumnTable *t, int col, uint32_t v);
+void coltable_f32(struct ColumnTable *t, int col, float v);
+
+// Completes the current row, writing a batch when it is full.
+void coltable_end_row(struct ColumnTable *t);
+
+// Writes any partial batch and frees the table.
+void coltable_finish(struct ColumnTable *t);
+
+// Writes the end block and flushes the stream, which stays open. Returns 0 if
+// every write succeeded.
+int colfile_close(struct ColumnFile *cf);
+
+#endif // COLEXPORT_H
@@ -0,0 +1,189 @@
+/**
+ * @file ephem.c
+ * @brief Columnar planet state container; see ephem.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "ephem.h"
+
+// Obliquity of the ecliptic at J2000 (IAU 2006), 84381.406 arcsec.
+#define J2000_OBLIQUITY_RAD (84381.406 / 3600.0 * 3.14159265358979323846 / 180.0)
+
+// Odd minimax coefficients for atan(t), |t| <= 1 (Abramowitz & Stegun 4.4.49,
+// |error| <= 2e-8 rad); the remaining error budget is single-precision rounding.
+#define ATAN_C1   1.0f
+#define ATAN_C3  -0.3333314528f
+#define ATAN_C5   0.1999355085f
+#define ATAN_C7  -0.1420889944f
+#define ATAN_C9   0.1065626393f
+#define ATAN_C11 -0.0752896400f
+#define ATAN_C13  0.0429096138f
+#define ATAN_C15 -0.0161657367f
+#define ATAN_C17  0.0028662257f
+
+#define TURN_TO_BAM 4294967296.0f
+#define RAD_TO_TURN 0.15915494309189535f
+#define RAD_TO_DEG 57.295779513082320f
+
+int planet_series_init(struct PlanetSeries *ps, int num_bodies, int num_days) {
+    size_t n = (size_t)num_bodies * num_days;
+    memset(ps, 0, sizeof(*ps));
+    ps->num_bodies = num_bodies;
+    ps->num_days = num_days;
+    ps->longitude = calloc(n, sizeof(*ps->longitude));
+    ps->speed = calloc(n, sizeof(*ps->speed));
+    ps->latitude = calloc(n, sizeof(*ps->latitude));
+    ps->sign = calloc(n, sizeof(*ps->sign));
+    if (!ps->longitude || !ps->speed || !ps->latitude || !ps->sign) {
+        planet_series_free(ps);
+        return -1;
+    }
+    return 0;
+}
+
+void planet_series_free(struct PlanetSeries *ps) {
+    free(ps->longitude);
+    free(ps->speed);
+    free(ps->latitude);
+    free(ps->sign);
+    memset(ps, 0, sizeof(*ps));
+}
+
+void planet_series_set(struct PlanetSeries *ps, int body, int day, bam32_t longitude, float latitude) {
+    size_t i = (size_t)body * ps->num_days + day;
+    ps->longitude[i] = longitude;
+    ps->latitude[i] = latitude;
+}
+
+void planet_series_finish(struct PlanetSeries *ps) {
+    size_t n = (size_t)ps->num_bodies * ps->num_days;
+    for (size_t i = 0; i < n; i++) {
+        ps->sign[i] = (uint8_t)bam_sign_index(ps->longitude[i]);
+    }
+
+    // Forward differences, with the last day repeating its predecessor's rate.
+    // A single-day series has no motion information and keeps speed at zero.
+    if (ps->num_days < 2) return;
+    for (int b = 0; b < ps->num_bodies; b++) {
+        const bam32_t *lon = ps->longitude + (size_t)b * ps->num_days;
+        float *speed = ps->speed + (size_t)b * ps->num_days;
+        for (int d = 0; d + 1 < ps->num_days; d++) {
+            speed[d] = (float)(bam_diff(lon[d + 1], lon[d]) * (360.0 / 4294967296.0));
+        }
+        speed[ps->num_days - 1] = speed[ps->num_days - 2];
+    }
+}
+
+struct PlanetSlice planet_series_day(const struct PlanetSeries *ps, int day) {
+    struct PlanetSlice s;
+    s.num_bodies = ps->num_bodies;
+    s.stride = ps->num_days;
+    s.longitude = ps->longitude + day;
+    s.speed = ps->speed + day;
+    s.latitude = ps->latitude + day;
+    s.sign = ps->sign + day;
+    return s;
+}
+
+// Scalar reference for the SIMD kernel; returns atan2(y, x) in radians.
+static float atan2_poly(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax > ay ? ay : ax;
+    float t = mx > 0.0f ? mn / mx : 0.0f;
+    float t2 = t * t;
+    float p = ATAN_C17;
+    p = p * t2 + ATAN_C15;
+    p = p * t2 + ATAN_C13;
+    p = p * t2 + ATAN_C11;
+    p = p * t2 + ATAN_C9;
+    p = p * t2 + ATAN_C7;
+    p = p * t2 + ATAN_C5;
+    p = p * t2 + ATAN_C3;
+    p = p * t2 + ATAN_C1;
+    float a = p * t;
+    if (ay > ax) a = 1.57079632679f - a;
+    if (x < 0.0f) a = 3.14159265359f - a;
+    return y < 0.0f ? -a : a;
+}
+
+#ifdef __SSE2__
+static inline __m128 atan2_poly4(__m128 y, __m128 x) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sign_mask, x);
+    __m128 ay = _mm_andnot_ps(sign_mask, y);
+    __m128 mx = _mm_max_ps(ax, ay);
+    __m128 mn = _mm_min_ps(ax, ay);
+    // 0/0 yields NaN; mask it to zero so the origin maps to 0 like atan2().
+    __m128 t = _mm_and_ps(_mm_div_ps(mn, mx), _mm_cmpgt_ps(mx, _mm_setzero_ps()));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(ATAN_C17);
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C15));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C13));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C11));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C9));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C7));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C1));
+    __m128 a = _mm_mul_ps(p, t);
+
+    // Octant and quadrant corrections as blends instead of branches.
+    __m128 steep = _mm_cmpgt_ps(ay, ax);
+    a = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(1.57079632679f), a)), _mm_andnot_ps(steep, a));
+    __m128 left = _mm_cmplt_ps(x, _mm_setzero_ps());
+    a = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(_mm_set1_ps(3.14159265359f), a)), _mm_andnot_ps(left, a));
+    return _mm_or_ps(a, _mm_and_ps(sign_mask, y));
+}
+#endif
+
+void ephem_vectors_to_ecliptic(const double *x, const double *y, const double *z, size_t n,
+                               enum EphemFrame frame, bam32_t *longitude, float *latitude) {
+    const double ce = cos(J2000_OBLIQUITY_RAD), se = sin(J2000_OBLIQUITY_RAD);
+    const double rc = frame == FRAME_EQUATORIAL ? ce : 1.0;
+    const double rs = frame == FRAME_EQUATORIAL ? se : 0.0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128d c = _mm_set1_pd(rc), s = _mm_set1_pd(rs);
+    for (; i + 4 <= n; i += 4) {
+        // Rotate about the X axis in double precision, then narrow to four float lanes.
+        __m128d y0 = _mm_loadu_pd(y + i), y1 = _mm_loadu_pd(y + i + 2);
+        __m128d z0 = _mm_loadu_pd(z + i), z1 = _mm_loadu_pd(z + i + 2);
+        __m128d ey0 = _mm_add_pd(_mm_mul_pd(y0, c), _mm_mul_pd(z0, s));
+        __m128d ey1 = _mm_add_pd(_mm_mul_pd(y1, c), _mm_mul_pd(z1, s));
+        __m128d ez0 = _mm_sub_pd(_mm_mul_pd(z0, c), _mm_mul_pd(y0, s));
+        __m128d ez1 = _mm_sub_pd(_mm_mul_pd(z1, c), _mm_mul_pd(y1, s));
+        __m128d x0 = _mm_loadu_pd(x + i), x1 = _mm_loadu_pd(x + i + 2);
+        __m128d rho0 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x0, x0), _mm_mul_pd(ey0, ey0)));
+        __m128d rho1 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x1, x1), _mm_mul_pd(ey1, ey1)));
+
+        __m128 fx = _mm_movelh_ps(_mm_cvtpd_ps(x0), _mm_cvtpd_ps(x1));
+        __m128 fy = _mm_movelh_ps(_mm_cvtpd_ps(ey0), _mm_cvtpd_ps(ey1));
+        __m128 fz = _mm_movelh_ps(_mm_cvtpd_ps(ez0), _mm_cvtpd_ps(ez1));
+        __m128 frho = _mm_movelh_ps(_mm_cvtpd_ps(rho0), _mm_cvtpd_ps(rho1));
+
+        // Longitude in [-0.5, 0.5] turns scaled to BAM; +0.5 turns saturates to
+        // INT32_MIN, which is the same angle.
+        __m128 turns = _mm_mul_ps(atan2_poly4(fy, fx), _mm_set1_ps(RAD_TO_TURN));
+        __m128i lon = _mm_cvtps_epi32(_mm_mul_ps(turns, _mm_set1_ps(TURN_TO_BAM)));
+        _mm_storeu_si128((__m128i *)(longitude + i), lon);
+        _mm_storeu_ps(latitude + i, _mm_mul_ps(atan2_poly4(fz, frho), _mm_set1_ps(RAD_TO_DEG)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        double ey = y[i] * rc + z[i] * rs;
+        double ez = z[i] * rc - y[i] * rs;
+        float rho = (float)sqrt(x[i] * x[i] + ey * ey);
+        float turns = atan2_poly((float)ey, (float)x[i]) * RAD_TO_TURN;
+        longitude[i] = (bam32_t)lrintf(turns * TURN_TO_BAM);
+        latitude[i] = atan2_poly((float)ez, rho) * RAD_TO_DEG;
+    }
+}
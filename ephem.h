@@ -0,0 +1,73 @@
+/**
+ * @file ephem.h
+ * @brief Columnar (struct-of-arrays) storage for planetary state over time.
+ *
+ * Every quantity lives in its own contiguous column, laid out body-major:
+ * element [body * num_days + day]. A body's history is therefore one linear
+ * run per column, which is what range and batch kernels stream over. A single
+ * day across all bodies is exposed as a strided PlanetSlice, which is what the
+ * forecast and aspect code consumes.
+ */
+
+#ifndef EPHEM_H
+#define EPHEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bam.h"
+
+struct PlanetSeries {
+    int num_bodies;
+    int num_days;
+    bam32_t *longitude; // Geocentric ecliptic longitude
+    float *speed;       // Degrees per day, from day-to-day differences
+    float *latitude;    // Ecliptic latitude in degrees
+    uint8_t *sign;      // Zodiac sign index 0-11
+};
+
+// One day of a PlanetSeries, across all bodies. Element i is at [i * stride].
+struct PlanetSlice {
+    int num_bodies;
+    size_t stride;
+    const bam32_t *longitude;
+    const float *speed;
+    const float *latitude;
+    const uint8_t *sign;
+};
+
+// Allocates zeroed columns for num_bodies x num_days. Returns 0 on success, -1 on failure.
+int planet_series_init(struct PlanetSeries *ps, int num_bodies, int num_days);
+void planet_series_free(struct PlanetSeries *ps);
+
+// Stores the position of one body on one day.
+void planet_series_set(struct PlanetSeries *ps, int body, int day, bam32_t longitude, float latitude);
+
+// Derives the sign and speed columns once all positions have been stored.
+void planet_series_finish(struct PlanetSeries *ps);
+
+// Returns the view of one day across all bodies.
+struct PlanetSlice planet_series_day(const struct PlanetSeries *ps, int day);
+
+// Reference plane of input position vectors.
+enum EphemFrame {
+    FRAME_ECLIPTIC,   // J2000 ecliptic (Horizons REF_PLANE='ECLIPTIC', the default)
+    FRAME_EQUATORIAL  // ICRF / J2000 equator; rotated by the J2000 obliquity
+};
+
+// Converts n Cartesian vectors into ecliptic longitude and latitude (degrees).
+// Uses a branch-free polynomial atan2, four rows per SSE2 step, evaluated in
+// single precision. Maximum error is below 4e-7 rad (0.08 arcsec), far inside
+// any sign or orb boundary we test. Inputs need not be normalised.
+void ephem_vectors_to_ecliptic(const double *x, const double *y, const double *z, size_t n,
+                               enum EphemFrame frame, bam32_t *longitude, float *latitude);
+
+static inline bam32_t slice_longitude(const struct PlanetSlice *s, int body) {
+    return s->longitude[body * s->stride];
+}
+
+static inline int slice_sign(const struct PlanetSlice *s, int body) {
+    return s->sign[body * s->stride];
+}
+
+#endif // EPHEM_H
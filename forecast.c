@@ -0,0 +1,71 @@
+/**
+ * @file forecast.c
+ * @brief Computes structured forecasts; see forecast.h.
+ */
+
+#include "forecast.h"
+#include "jday.h"
+
+enum Aspect classify_aspect(bam32_t planet_longitude, bam32_t sun_longitude, bam32_t *orb) {
+    static const struct { enum Aspect aspect; bam32_t angle, orb; } tests[] = {
+        { ASPECT_CONJUNCTION, 0,            BAM_DEG(ORB_CONJ_OPP) },
+        { ASPECT_OPPOSITION,  BAM_180,      BAM_DEG(ORB_CONJ_OPP) },
+        { ASPECT_TRINE,       BAM_DEG(120), BAM_DEG(ORB_TRINE_SQR_SEX) },
+        { ASPECT_SQUARE,      BAM_DEG(90),  BAM_DEG(ORB_TRINE_SQR_SEX) },
+        { ASPECT_SEXTILE,     BAM_DEG(60),  BAM_DEG(ORB_TRINE_SQR_SEX) },
+    };
+    bam32_t angle_diff = bam_sep(planet_longitude, sun_longitude);
+
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        bam32_t distance = bam_sep(angle_diff, tests[i].angle);
+        if (distance <= tests[i].orb) {
+            if (orb) *orb = distance;
+            return tests[i].aspect;
+        }
+    }
+    return ASPECT_NONE;
+}
+
+void forecast_compute_sky(struct Forecast *f, const struct PlanetSlice *day, int sun_sign, int sun_body) {
+    f->sun_sign = sun_sign;
+    f->num_bodies = day->num_bodies < FORECAST_MAX_BODIES ? day->num_bodies : FORECAST_MAX_BODIES;
+    f->num_aspects = 0;
+    f->positive_aspects = 0;
+    f->negative_aspects = 0;
+    f->focus_house = 0;
+
+    bam32_t sun_sign_longitude = BAM_DEG(sun_sign * 30.0 + 15.0);
+    for (int i = 0; i < f->num_bodies; i++) {
+        // Whole Sign House system: the Sun sign is the 1st house.
+        f->house[i] = (slice_sign(day, i) - sun_sign + 12) % 12 + 1;
+        if (i == sun_body) f->focus_house = f->house[i];
+
+        bam32_t orb;
+        enum Aspect aspect = classify_aspect(slice_longitude(day, i), sun_sign_longitude, &orb);
+        if (aspect == ASPECT_NONE) continue;
+        f->aspects[f->num_aspects].body = i;
+        f->aspects[f->num_aspects].aspect = aspect;
+        f->aspects[f->num_aspects].orb = (float)bam_to_deg(orb);
+        f->num_aspects++;
+
+        if (aspect == ASPECT_TRINE || aspect == ASPECT_SEXTILE) f->positive_aspects++;
+        if (aspect == ASPECT_OPPOSITION || aspect == ASPECT_SQUARE) f->negative_aspects++;
+    }
+}
+
+void forecast_compute_biorhythm(struct Forecast *f, int year, int month, int day, int birth_minute) {
+    double day_fraction;
+    long jdn = jd_now_utc(&day_fraction);
+    forecast_compute_biorhythm_on(f, year, month, day, birth_minute, jdn, day_fraction);
+}
+
+void forecast_compute_biorhythm_on(struct Forecast *f, int year, int month, int day, int birth_minute, long jdn,
+                                   double day_fraction) {
+    // Without a birth time the count is in whole days and served from the phase tables.
+    if (birth_minute >= 0) {
+        double birth_jd = jd_from_civil(year, month, day) - 0.5 + birth_minute / (24.0 * 60.0);
+        biorhythm_exact(jdn - 0.5 + day_fraction - birth_jd, &f->bio);
+    } else {
+        biorhythm_lookup(jdn - jd_from_civil(year, month, day), &f->bio);
+    }
+}
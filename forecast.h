@@ -0,0 +1,76 @@
+/**
+ * @file forecast.h
+ * @brief Structured daily forecast: the astronomy and arithmetic behind a
+ * report, kept apart from any text rendering.
+ *
+ * A Forecast is computed once per user and then rendered, cached or
+ * serialized as many times as needed. Its sky part (houses, aspects, their
+ * tallies and the focus house) depends only on the Sun sign and the day's
+ * positions, so callers serving many users may compute it once per sign and
+ * copy it; the biorhythm part is per user.
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include "bam.h"
+#include "biorhythm.h"
+#include "ephem.h"
+
+#define FORECAST_MAX_BODIES 16
+
+#define ORB_CONJ_OPP 8.0 // Orb of 8 degrees for Conjunction and Opposition
+#define ORB_TRINE_SQR_SEX 6.0 // Orb of 6 degrees for Trine, Square, and Sextile
+
+// Major aspects, in the order they are tested.
+enum Aspect {
+    ASPECT_NONE, ASPECT_CONJUNCTION, ASPECT_OPPOSITION, ASPECT_TRINE, ASPECT_SQUARE, ASPECT_SEXTILE
+};
+
+// Overall astrological tone, from the balance of positive and negative aspects.
+enum ForecastOutlook {
+    OUTLOOK_MIXED, OUTLOOK_POSITIVE, OUTLOOK_CHALLENGING
+};
+
+struct ForecastAspect {
+    int body;          // Index into the day's bodies
+    enum Aspect aspect;
+    float orb;         // Degrees away from the exact aspect angle, 0 to the aspect's orb
+};
+
+struct Forecast {
+    int sun_sign;      // 0-11
+    int num_bodies;
+    int house[FORECAST_MAX_BODIES]; // Whole-sign house 1-12 each body transits
+    int num_aspects;
+    struct ForecastAspect aspects[FORECAST_MAX_BODIES]; // In body order
+    int positive_aspects; // Trines and sextiles
+    int negative_aspects; // Squares and oppositions
+    int focus_house;   // House the Sun transits, 1-12; 0 when the Sun is not among the bodies
+    struct Biorhythm bio;
+};
+
+// Classifies the angle between a planet and the Sun sign midpoint as a major
+// aspect. When orb is not NULL it receives the distance from the exact angle.
+enum Aspect classify_aspect(bam32_t planet_longitude, bam32_t sun_longitude, bam32_t *orb);
+
+static inline enum ForecastOutlook forecast_outlook(const struct Forecast *f) {
+    if (f->positive_aspects > f->negative_aspects) return OUTLOOK_POSITIVE;
+    if (f->negative_aspects > f->positive_aspects) return OUTLOOK_CHALLENGING;
+    return OUTLOOK_MIXED;
+}
+
+// Fills in the sky part of f for a Sun sign. sun_body is the index of the Sun
+// among the day's bodies, or -1. At most FORECAST_MAX_BODIES bodies are used.
+void forecast_compute_sky(struct Forecast *f, const struct PlanetSlice *day, int sun_sign, int sun_body);
+
+// Fills in today's biorhythm values. With a birth minute (>= 0) the count of
+// days alive is exact to the minute; otherwise whole days are used.
+void forecast_compute_biorhythm(struct Forecast *f, int year, int month, int day, int birth_minute);
+
+// As forecast_compute_biorhythm, for day_fraction of a day past 0h UT on the
+// day jdn instead of now. Only the birth-minute path uses day_fraction.
+void forecast_compute_biorhythm_on(struct Forecast *f, int year, int month, int day, int birth_minute, long jdn,
+                                   double day_fraction);
+
+#endif // FORECAST_H
@@ -0,0 +1,171 @@
+/**
+ * @file gzstream.c
+ * @brief Double-buffered gzip compression thread; see gzstream.h.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "gzstream.h"
+#include "stopwatch.h"
+
+#define GZ_BUFFER_SIZE (1 << 20) // Bytes per input buffer; two are in play
+
+struct GzStream {
+    int fd;
+    z_stream zs;
+    unsigned char *buffers[2];
+    int current;              // Buffer the producer appends to
+    size_t fill;              // Bytes in the current buffer
+    const unsigned char *pending; // Buffer handed to the compressor, or NULL
+    size_t pending_len;
+    int finishing;
+    int failed;
+    unsigned char *out;       // Deflate output, written to fd as it fills
+    struct GzStats stats;
+    double opened;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+};
+
+static int write_fd(int fd, const unsigned char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= w;
+    }
+    return 0;
+}
+
+// Deflates one input block (flush is Z_NO_FLUSH or Z_FINISH) and writes the output.
+static int deflate_block(struct GzStream *z, const unsigned char *data, size_t n, int flush) {
+    z->zs.next_in = (unsigned char *)data;
+    z->zs.avail_in = (uInt)n;
+    int ret;
+    do {
+        z->zs.next_out = z->out;
+        z->zs.avail_out = GZ_BUFFER_SIZE;
+        ret = deflate(&z->zs, flush);
+        if (ret == Z_STREAM_ERROR) return -1;
+        size_t produced = GZ_BUFFER_SIZE - z->zs.avail_out;
+        if (write_fd(z->fd, z->out, produced) != 0) return -1;
+        z->stats.bytes_out += produced;
+    } while (z->zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    return 0;
+}
+
+static void *compressor_main(void *arg) {
+    struct GzStream *z = arg;
+    pthread_mutex_lock(&z->lock);
+    for (;;) {
+        while (!z->pending && !z->finishing) pthread_cond_wait(&z->cond, &z->lock);
+        const unsigned char *data = z->pending;
+        size_t n = data ? z->pending_len : 0;
+        int finish = !data; // Woken with nothing pending only once finishing
+        pthread_mutex_unlock(&z->lock);
+
+        double t0 = stopwatch_seconds();
+        int status = z->failed ? -1 : deflate_block(z, data, n, finish ? Z_FINISH : Z_NO_FLUSH);
+        z->stats.busy_seconds += stopwatch_seconds() - t0;
+
+        pthread_mutex_lock(&z->lock);
+        if (status != 0) __atomic_store_n(&z->failed, 1, __ATOMIC_RELAXED);
+        if (finish) break;
+        z->pending = NULL;
+        pthread_cond_broadcast(&z->cond);
+    }
+    pthread_mutex_unlock(&z->lock);
+    return NULL;
+}
+
+struct GzStream *gz_stream_open(int fd, int level) {
+    struct GzStream *z = calloc(1, sizeof(*z));
+    if (!z) return NULL;
+    z->fd = fd;
+    z->opened = stopwatch_seconds();
+    z->buffers[0] = malloc(GZ_BUFFER_SIZE);
+    z->buffers[1] = malloc(GZ_BUFFER_SIZE);
+    z->out = malloc(GZ_BUFFER_SIZE);
+    // 15 + 16 selects a gzip rather than a raw zlib wrapper.
+    int ok = z->buffers[0] && z->buffers[1] && z->out &&
+             deflateInit2(&z->zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (ok) {
+        pthread_mutex_init(&z->lock, NULL);
+        pthread_cond_init(&z->cond, NULL);
+        if (pthread_create(&z->thread, NULL, compressor_main, z) != 0) {
+            pthread_mutex_destroy(&z->lock);
+            pthread_cond_destroy(&z->cond);
+            deflateEnd(&z->zs);
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        free(z->buffers[0]);
+        free(z->buffers[1]);
+        free(z->out);
+        free(z);
+        return NULL;
+    }
+    return z;
+}
+
+// Hands the current buffer to the compressor, waiting until it has finished the other one.
+static void hand_off(struct GzStream *z) {
+    pthread_mutex_lock(&z->lock);
+    while (z->pending) pthread_cond_wait(&z->cond, &z->lock);
+    z->pending = z->buffers[z->current];
+    z->pending_len = z->fill;
+    pthread_cond_broadcast(&z->cond);
+    pthread_mutex_unlock(&z->lock);
+    z->current ^= 1;
+    z->fill = 0;
+}
+
+int gz_stream_write(struct GzStream *z, const void *data, size_t n) {
+    const unsigned char *p = data;
+    z->stats.bytes_in += n;
+    while (n > 0) {
+        size_t take = GZ_BUFFER_SIZE - z->fill;
+        if (take > n) take = n;
+        memcpy(z->buffers[z->current] + z->fill, p, take);
+        z->fill += take;
+        p += take;
+        n -= take;
+        if (z->fill == GZ_BUFFER_SIZE) hand_off(z);
+    }
+    return __atomic_load_n(&z->failed, __ATOMIC_RELAXED) ? -1 : 0;
+}
+
+int gz_stream_close(struct GzStream *z, struct GzStats *stats) {
+    if (z->fill) hand_off(z);
+    pthread_mutex_lock(&z->lock);
+    z->finishing = 1;
+    pthread_cond_broadcast(&z->cond);
+    pthread_mutex_unlock(&z->lock);
+    pthread_join(z->thread, NULL);
+
+    z->stats.wall_seconds = stopwatch_seconds() - z->opened;
+    if (stats) *stats = z->stats;
+    int status = z->failed ? -1 : 0;
+    deflateEnd(&z->zs);
+    pthread_mutex_destroy(&z->lock);
+    pthread_cond_destroy(&z->cond);
+    free(z->buffers[0]);
+    free(z->buffers[1]);
+    free(z->out);
+    free(z);
+    return status;
+}
+
+int gz_path(const char *path) {
+    size_t n = strlen(path);
+    return n > 3 && strcmp(path + n - 3, ".gz") == 0;
+}
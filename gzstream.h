@@ -0,0 +1,42 @@
+/**
+ * @file gzstream.h
+ * @brief gzip compression on a dedicated thread, fed through two buffers.
+ *
+ * The producer appends into one buffer while the compressor thread deflates
+ * and writes the other, so compression overlaps whatever produces the data.
+ * The producer only waits when it fills a buffer before the compressor has
+ * finished the previous one.
+ */
+
+#ifndef GZSTREAM_H
+#define GZSTREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GZ_DEFAULT_LEVEL (-1) // zlib's default trade-off, level 6
+
+struct GzStream;
+
+struct GzStats {
+    uint64_t bytes_in;   // Uncompressed bytes accepted
+    uint64_t bytes_out;  // Compressed bytes written
+    double busy_seconds; // Time the compressor thread spent deflating and writing
+    double wall_seconds; // Time from open to close
+};
+
+// Starts compressing into fd with a zlib level (0-9, or GZ_DEFAULT_LEVEL).
+// The descriptor stays owned by the caller. Returns NULL on failure.
+struct GzStream *gz_stream_open(int fd, int level);
+
+// Queues n bytes. Returns 0 on success, -1 once compression or writing has failed.
+int gz_stream_write(struct GzStream *z, const void *data, size_t n);
+
+// Compresses the rest, ends the gzip member and frees the stream. When stats
+// is not NULL it receives the totals. Returns 0 if everything was written.
+int gz_stream_close(struct GzStream *z, struct GzStats *stats);
+
+// True when a path names a gzip file, i.e. ends in ".gz".
+int gz_path(const char *path);
+
+#endif // GZSTREAM_H
@@ -0,0 +1,137 @@
+/**
+ * @file horizons.c
+ * @brief NASA JPL Horizons client; see horizons.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "horizons.h"
+#include "jday.h"
+
+#define HORIZONS_URL "https://ssd.jpl.nasa.gov/api/horizons.api?format=json&COMMAND='%s'&OBJ_DATA='NO'&MAKE_EPHEM='YES'&EPHEM_TYPE='VECTORS'&CENTER='%s'&START_TIME='%s'&STOP_TIME='%s'&STEP_SIZE='1d'&TIME_TYPE='UT'&VEC_TABLE='1'"
+
+// Struct to hold the response data from a curl request.
+struct MemoryStruct {
+    char *memory;
+    size_t size;
+};
+
+// Callback function for libcurl
+static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
+    if (ptr == NULL) return 0;
+    mem->memory = ptr;
+    memcpy(&(mem->memory[mem->size]), contents, realsize);
+    mem->size += realsize;
+    mem->memory[mem->size] = 0;
+    return realsize;
+}
+
+int parse_planet_vectors(const char *json_text, double *x, double *y, double *z, int max_rows) {
+    json_error_t error;
+    json_t *root = json_loads(json_text, 0, &error);
+    if (!root) return -1;
+    json_t *result = json_object_get(root, "result");
+    if (!json_is_string(result)) { json_decref(root); return -1; }
+    const char *result_text = json_string_value(result);
+    const char *data_start = strstr(result_text, "$$SOE");
+    if (!data_start) { json_decref(root); return -1; }
+    const char *data_end = strstr(data_start, "$$EOE");
+
+    int rows = 0;
+    const char *row = data_start;
+    while (rows < max_rows && (row = strstr(row, "X =")) != NULL && (!data_end || row < data_end)) {
+        if (sscanf(row, "X =%lf Y =%lf Z =%lf", &x[rows], &y[rows], &z[rows]) != 3) break;
+        rows++;
+        row += 3;
+    }
+
+    json_decref(root);
+    return rows > 0 ? rows : -1;
+}
+
+int horizons_fetch_vectors(CURL *curl, const char *command, const char *center, long first_jdn, long last_jdn,
+                           double *x, double *y, double *z, int max_rows) {
+    char start_str[11], stop_str[11];
+    jd_format(first_jdn, start_str);
+    // Horizons rejects a stop time equal to the start, so single days ask for two rows.
+    jd_format(last_jdn > first_jdn ? last_jdn : first_jdn + 1, stop_str);
+
+    struct MemoryStruct chunk = { .memory = malloc(1), .size = 0 };
+    if (!chunk.memory) return HORIZONS_ERR_TRANSPORT;
+    char url[512];
+    snprintf(url, sizeof(url), HORIZONS_URL, command, center, start_str, stop_str);
+
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+
+    int rows;
+    if (curl_easy_perform(curl) != CURLE_OK) {
+        rows = HORIZONS_ERR_TRANSPORT;
+    } else {
+        rows = parse_planet_vectors(chunk.memory, x, y, z, max_rows);
+        if (rows < 0) rows = HORIZONS_ERR_PARSE;
+    }
+    free(chunk.memory);
+    return rows;
+}
+
+int horizons_fetch_series(CURL *curl, const char *const body_ids[], long first_jdn, struct PlanetSeries *ps) {
+    size_t n = (size_t)ps->num_bodies * ps->num_days;
+    double *vec_x = calloc(n, sizeof(double));
+    double *vec_y = calloc(n, sizeof(double));
+    double *vec_z = calloc(n, sizeof(double));
+    if (!vec_x || !vec_y || !vec_z) {
+        free(vec_x);
+        free(vec_y);
+        free(vec_z);
+        return 0;
+    }
+
+    // Raw vectors are laid out body-major like the series columns, so a single
+    // kernel call converts them all. A failed fetch leaves zero vectors,
+    // which map to longitude 0.
+    int fetched = 0;
+    long last_jdn = first_jdn + ps->num_days - 1;
+    for (int b = 0; b < ps->num_bodies; b++) {
+        double *x = vec_x + (size_t)b * ps->num_days;
+        double *y = vec_y + (size_t)b * ps->num_days;
+        double *z = vec_z + (size_t)b * ps->num_days;
+        int rows = horizons_fetch_vectors(curl, body_ids[b], "@399", first_jdn, last_jdn, x, y, z, ps->num_days);
+        if (rows <= 0) continue;
+        for (int d = rows; d < ps->num_days; d++) {
+            x[d] = x[rows - 1];
+            y[d] = y[rows - 1];
+            z[d] = z[rows - 1];
+        }
+        fetched++;
+    }
+
+    ephem_vectors_to_ecliptic(vec_x, vec_y, vec_z, n, FRAME_ECLIPTIC, ps->longitude, ps->latitude);
+    planet_series_finish(ps);
+
+    free(vec_x);
+    free(vec_y);
+    free(vec_z);
+    return fetched;
+}
+
+int horizons_sun_longitude(CURL *curl, long jdn, bam32_t *longitude) {
+    double x, y, z;
+    float latitude;
+    int rows = horizons_fetch_vectors(curl, "399", "@sun", jdn, jdn, &x, &y, &z, 1);
+    if (rows < 0) return rows;
+
+    bam32_t earth_longitude;
+    ephem_vectors_to_ecliptic(&x, &y, &z, 1, FRAME_ECLIPTIC, &earth_longitude, &latitude);
+    *longitude = earth_longitude + BAM_180;
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file horizons.h
+ * @brief Requests to the NASA JPL Horizons API and parsing of its vector tables.
+ *
+ * All fetches take a caller-owned CURL handle so that consecutive requests
+ * reuse one connection. Dates are Julian Day Numbers (see jday.h), and each
+ * day's vector is for 0h UT on that date.
+ */
+
+#ifndef HORIZONS_H
+#define HORIZONS_H
+
+#include <curl/curl.h>
+
+#include "bam.h"
+#include "ephem.h"
+
+#define HORIZONS_ERR_TRANSPORT -1 // The HTTP request failed
+#define HORIZONS_ERR_PARSE     -2 // The response held no vector rows
+
+// Parses up to max_rows X/Y/Z vectors (km) from a Horizons JSON response.
+// Returns the number of rows read, or -1 if the response holds none.
+int parse_planet_vectors(const char *json_text, double *x, double *y, double *z, int max_rows);
+
+// Fetches one vector per day for a body (Horizons COMMAND) relative to center,
+// from first_jdn to last_jdn inclusive. Returns the number of rows or a
+// HORIZONS_ERR_* code.
+int horizons_fetch_vectors(CURL *curl, const char *command, const char *center, long first_jdn, long last_jdn,
+                           double *x, double *y, double *z, int max_rows);
+
+// Fills an initialised series with geocentric positions for ps->num_days days
+// from first_jdn, using one ranged request per body. Missing trailing rows
+// repeat the last row received; a body that fails entirely is left at
+// longitude 0. Returns the number of bodies fetched.
+int horizons_fetch_series(CURL *curl, const char *const body_ids[], long first_jdn, struct PlanetSeries *ps);
+
+// The Sun's geocentric ecliptic longitude on a date, from Earth's heliocentric
+// vector. Returns 0 or a HORIZONS_ERR_* code.
+int horizons_sun_longitude(CURL *curl, long jdn, bam32_t *longitude);
+
+#endif // HORIZONS_H
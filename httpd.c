@@ -0,0 +1,445 @@
+/**
+ * @file httpd.c
+ * @brief epoll HTTP/1.1 server; see httpd.h.
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "httpd.h"
+
+#define HTTP_MAX_REQUEST 8192 // Request line and headers; longer requests get 431
+#define HTTP_MAX_EVENTS  64
+#define HTTP_TIMEOUT_MS  10000 // Longest wait for each complete request and its response
+#define HTTP_ACCEPT_PAUSE_MS 100 // Accepting stops this long when out of descriptors
+
+struct HttpConn {
+    int fd;
+    int closing;         // Close once the pending output is sent
+    int eof;             // The peer has finished sending
+    uint32_t interest;   // Events currently registered with epoll
+    int64_t deadline;    // Monotonic ms by which the next request must be answered
+    size_t in_len;
+    size_t out_sent;
+    struct OutBuf out;   // Responses not yet accepted by the socket
+    struct HttpConn *prev, *next;
+    char in[HTTP_MAX_REQUEST + 1]; // NUL-terminated at in_len
+};
+
+struct HttpWorker {
+    const struct HttpdConfig *config;
+    int index;
+    int listen_fd;
+    int epoll_fd;
+    int stop_fd;
+    int started;
+    struct OutBuf body;     // Handler output, reused for every request
+    struct HttpConn *conns; // Open connections, most recently active first
+    struct HttpConn *oldest; // Tail of conns: the earliest deadline
+    int64_t accept_resume;  // While nonzero, accepting is paused until this time
+    pthread_t thread;
+};
+
+// Tags for the epoll entries that are not connections.
+static char listen_tag, stop_tag;
+
+static const char *status_text(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 422: return "Unprocessable Entity";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
+    default: return "Internal Server Error";
+    }
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void conn_unlink(struct HttpWorker *w, struct HttpConn *c) {
+    if (c->prev) c->prev->next = c->next;
+    else w->conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    else w->oldest = c->prev;
+}
+
+// Gives the connection a fresh deadline. Every deadline is now plus the same
+// timeout, so keeping the list in activity order keeps it in deadline order.
+static void conn_touch(struct HttpWorker *w, struct HttpConn *c, int64_t now) {
+    c->deadline = now + HTTP_TIMEOUT_MS;
+    if (w->conns == c) return;
+    if (c->prev || c->next || w->oldest == c) conn_unlink(w, c);
+    c->prev = NULL;
+    c->next = w->conns;
+    if (w->conns) w->conns->prev = c;
+    else w->oldest = c;
+    w->conns = c;
+}
+
+static void conn_close(struct HttpWorker *w, struct HttpConn *c) {
+    conn_unlink(w, c);
+    close(c->fd); // Also removes it from the epoll set
+    outbuf_free(&c->out);
+    free(c);
+}
+
+// Queues a response; head_only leaves out the body but keeps its length.
+static void conn_respond(struct HttpConn *c, int status, const char *content_type, const struct OutBuf *body,
+                         int head_only) {
+    outbuf_printf(&c->out, "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n", status,
+                  status_text(status), content_type, body->len, c->closing ? "Connection: close\r\n" : "");
+    if (!head_only) outbuf_write(&c->out, body->data, body->len);
+}
+
+// Replies with a one-line plain-text error and closes the connection after it.
+static void conn_fail(struct HttpWorker *w, struct HttpConn *c, int status) {
+    w->body.len = 0;
+    outbuf_printf(&w->body, "%s\n", status_text(status));
+    c->closing = 1;
+    conn_respond(c, status, "text/plain; charset=utf-8", &w->body, 0);
+}
+
+// Value of a header line [line, end) when it is the named header, else NULL.
+static const char *header_value(const char *line, const char *end, const char *name) {
+    size_t name_len = strlen(name);
+    if ((size_t)(end - line) <= name_len || strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') {
+        return NULL;
+    }
+    const char *v = line + name_len + 1;
+    while (v < end && (*v == ' ' || *v == '\t')) v++;
+    return v;
+}
+
+// True when a header value [v, end) contains token, ignoring case.
+static int value_has(const char *v, const char *end, const char *token) {
+    size_t token_len = strlen(token);
+    for (; v + token_len <= end; v++) {
+        if (strncasecmp(v, token, token_len) == 0) return 1;
+    }
+    return 0;
+}
+
+// Answers one complete request whose head is [c->in, head_end).
+static void conn_handle(struct HttpWorker *w, struct HttpConn *c, const char *head_end) {
+    const char *line_end = strstr(c->in, "\r\n");
+    const char *target = memchr(c->in, ' ', line_end - c->in);
+    const char *version = target ? memchr(target + 1, ' ', line_end - target - 1) : NULL;
+    if (!version || line_end - version != 9 || strncmp(version + 1, "HTTP/1.", 7) != 0 || target[1] != '/') {
+        conn_fail(w, c, 400);
+        return;
+    }
+
+    // HTTP/1.1 stays open unless asked to close; HTTP/1.0 closes unless asked to stay.
+    int keep_alive = version[8] != '0';
+    for (const char *line = line_end + 2; line < head_end; line = strstr(line, "\r\n") + 2) {
+        const char *end = strstr(line, "\r\n");
+        const char *v;
+        if ((v = header_value(line, end, "Connection")) != NULL) {
+            if (value_has(v, end, "close")) keep_alive = 0;
+            if (value_has(v, end, "keep-alive")) keep_alive = 1;
+        }
+        // Bodies are never read, so a request carrying one cannot be framed.
+        if (header_value(line, end, "Transfer-Encoding") ||
+            ((v = header_value(line, end, "Content-Length")) != NULL && strtol(v, NULL, 10) != 0)) {
+            conn_fail(w, c, 400);
+            return;
+        }
+    }
+    if (!keep_alive) c->closing = 1;
+
+    int method_len = (int)(target - c->in);
+    int head_only = method_len == 4 && memcmp(c->in, "HEAD", 4) == 0;
+    if (!head_only && !(method_len == 3 && memcmp(c->in, "GET", 3) == 0)) {
+        conn_fail(w, c, 405);
+        return;
+    }
+
+    struct HttpRequest req;
+    const char *query = memchr(target, '?', version - target);
+    req.path = target + 1;
+    req.path_len = (int)((query ? query : version) - req.path);
+    req.query = query ? query + 1 : NULL;
+    req.query_len = query ? (int)(version - query - 1) : 0;
+    req.worker = w->index;
+
+    w->body.len = 0;
+    struct HttpResponse res = { .status = 200, .content_type = "text/plain; charset=utf-8", .body = &w->body };
+    w->config->handler(w->config->ctx, &req, &res);
+    conn_respond(c, res.status, res.content_type, res.body, head_only);
+}
+
+// Sends as much pending output as the socket takes. Returns -1 on a socket error.
+static int conn_flush(struct HttpConn *c) {
+    while (c->out_sent < c->out.len) {
+        ssize_t n = send(c->fd, c->out.data + c->out_sent, c->out.len - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        c->out_sent += (size_t)n;
+    }
+    c->out.len = 0;
+    c->out_sent = 0;
+    return 0;
+}
+
+// Reads what has arrived and answers every complete request in it, in order.
+// Returns -1 when the connection should be dropped at once.
+static int conn_read(struct HttpWorker *w, struct HttpConn *c, int64_t now) {
+    while (c->in_len < HTTP_MAX_REQUEST) {
+        ssize_t n = recv(c->fd, c->in + c->in_len, HTTP_MAX_REQUEST - c->in_len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) return -1;
+        if (n == 0) {
+            c->eof = 1;
+            break;
+        }
+        c->in_len += (size_t)n;
+        c->in[c->in_len] = '\0';
+    }
+
+    const char *head_end;
+    while (!c->closing && (head_end = strstr(c->in, "\r\n\r\n")) != NULL) {
+        conn_handle(w, c, head_end + 2);
+        conn_touch(w, c, now);
+        size_t used = (size_t)(head_end + 4 - c->in);
+        memmove(c->in, c->in + used, c->in_len - used + 1);
+        c->in_len -= used;
+    }
+    if (c->in_len == HTTP_MAX_REQUEST && !c->closing) conn_fail(w, c, 431);
+    // Everything the peer sent is answered; close once it has gone out.
+    if (c->eof) c->closing = 1;
+    return 0;
+}
+
+// Registers for output while a response is pending and for input otherwise;
+// closes the connection once it is finished.
+static void conn_update(struct HttpWorker *w, struct HttpConn *c) {
+    if (c->out.len == 0 && c->closing) {
+        conn_close(w, c);
+        return;
+    }
+    uint32_t interest = c->out.len ? EPOLLOUT : EPOLLIN;
+    if (interest == c->interest) return;
+    struct epoll_event ev = { .events = interest, .data.ptr = c };
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->interest = interest;
+}
+
+// Stops or restarts watching the listening socket.
+static void accept_pause(struct HttpWorker *w, int64_t resume) {
+    struct epoll_event ev = { .events = resume ? 0 : EPOLLIN, .data.ptr = &listen_tag };
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, w->listen_fd, &ev);
+    w->accept_resume = resume;
+}
+
+static void accept_all(struct HttpWorker *w, int64_t now) {
+    for (;;) {
+        int fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // The listening socket stays readable while out of descriptors, so
+            // stop watching it for a moment instead of spinning on it.
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                accept_pause(w, now + HTTP_ACCEPT_PAUSE_MS);
+            }
+            return; // EAGAIN once the backlog is empty; other errors retry on the next event
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        struct HttpConn *c = malloc(sizeof(*c));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->closing = 0;
+        c->eof = 0;
+        c->interest = EPOLLIN;
+        c->in_len = 0;
+        c->in[0] = '\0';
+        c->out_sent = 0;
+        outbuf_init(&c->out);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if (epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        c->prev = c->next = NULL;
+        conn_touch(w, c, now);
+    }
+}
+
+// Closes connections past their deadline. Returns the epoll_wait() timeout
+// until the next deadline or accept restart, or -1 when there is none.
+static int expire(struct HttpWorker *w, int64_t now) {
+    while (w->oldest && w->oldest->deadline <= now) conn_close(w, w->oldest);
+    if (w->accept_resume && w->accept_resume <= now) accept_pause(w, 0);
+
+    int64_t next = w->oldest ? w->oldest->deadline : INT64_MAX;
+    if (w->accept_resume && w->accept_resume < next) next = w->accept_resume;
+    return next == INT64_MAX ? -1 : (int)(next - now);
+}
+
+static void *worker_main(void *arg) {
+    struct HttpWorker *w = arg;
+    struct epoll_event events[HTTP_MAX_EVENTS];
+    int running = 1;
+    int timeout = -1;
+    while (running) {
+        int n = epoll_wait(w->epoll_fd, events, HTTP_MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) break;
+        int64_t now = now_ms();
+        for (int i = 0; i < n; i++) {
+            void *tag = events[i].data.ptr;
+            if (tag == &stop_tag) {
+                running = 0;
+            } else if (tag == &listen_tag) {
+                accept_all(w, now);
+            } else {
+                struct HttpConn *c = tag;
+                int failed = (events[i].events & EPOLLERR) != 0;
+                if (!failed && (events[i].events & (EPOLLIN | EPOLLHUP))) failed = conn_read(w, c, now) != 0;
+                if (!failed) failed = conn_flush(c) != 0;
+                if (failed) conn_close(w, c);
+                else conn_update(w, c);
+            }
+        }
+        timeout = expire(w, now);
+    }
+    while (w->conns) conn_close(w, w->conns);
+    return NULL;
+}
+
+// Opens a worker's listening socket and epoll set. Returns 0 or -1.
+static int worker_open(struct HttpWorker *w, const struct sockaddr_in *addr) {
+    w->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    w->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->listen_fd < 0 || w->epoll_fd < 0) return -1;
+    int one = 1;
+    setsockopt(w->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(w->listen_fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    if (bind(w->listen_fd, (const struct sockaddr *)addr, sizeof(*addr)) != 0 ||
+        listen(w->listen_fd, SOMAXCONN) != 0) {
+        return -1;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listen_tag };
+    struct epoll_event stop = { .events = EPOLLIN, .data.ptr = &stop_tag };
+    if (epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, w->listen_fd, &ev) != 0 ||
+        epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, w->stop_fd, &stop) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int httpd_run(const struct HttpdConfig *config) {
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons((uint16_t)config->port) };
+    if (inet_pton(AF_INET, config->address, &addr.sin_addr) != 1) {
+        printf("Error: Invalid listen address %s.\n", config->address);
+        return -1;
+    }
+
+    // Workers inherit the blocked mask, so the signals reach only sigwait() below.
+    sigset_t signals, old_mask;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &old_mask);
+
+    // Never read, so once written it stays readable in every worker's epoll set.
+    int stop_fd = eventfd(0, EFD_CLOEXEC);
+    struct HttpWorker *workers = calloc(config->num_threads, sizeof(*workers));
+    int status = stop_fd >= 0 && workers ? 0 : -1;
+    for (int i = 0; workers && i < config->num_threads; i++) {
+        workers[i].config = config;
+        workers[i].index = i;
+        workers[i].listen_fd = workers[i].epoll_fd = -1;
+        workers[i].stop_fd = stop_fd;
+        outbuf_init(&workers[i].body);
+        if (status == 0 && worker_open(&workers[i], &addr) != 0) {
+            printf("Error: Could not listen on %s:%d (%s).\n", config->address, config->port, strerror(errno));
+            status = -1;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; status == 0 && i < config->num_threads; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) == 0;
+        started += workers[i].started;
+    }
+    if (status == 0 && started > 0) {
+        fprintf(stderr, "Serving on http://%s:%d/ with %d threads.\n", config->address, config->port, started);
+        int sig;
+        sigwait(&signals, &sig);
+        fprintf(stderr, "Shutting down.\n");
+        uint64_t one = 1;
+        if (write(stop_fd, &one, sizeof(one)) != sizeof(one)) status = -1;
+    } else {
+        status = -1;
+    }
+
+    for (int i = 0; workers && i < config->num_threads; i++) {
+        if (workers[i].started) pthread_join(workers[i].thread, NULL);
+        if (workers[i].listen_fd >= 0) close(workers[i].listen_fd);
+        if (workers[i].epoll_fd >= 0) close(workers[i].epoll_fd);
+        outbuf_free(&workers[i].body);
+    }
+    free(workers);
+    if (stop_fd >= 0) close(stop_fd);
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    return status;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int http_query_param(const struct HttpRequest *req, const char *name, char *out, size_t cap) {
+    size_t name_len = strlen(name);
+    const char *p = req->query, *end = req->query + req->query_len;
+    while (p && p < end) {
+        const char *amp = memchr(p, '&', end - p);
+        const char *pair_end = amp ? amp : end;
+        if ((size_t)(pair_end - p) > name_len && memcmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            size_t len = 0;
+            for (const char *v = p + name_len + 1; v < pair_end; v++) {
+                if (len + 1 >= cap) return -1;
+                int hi, lo;
+                if (*v == '%' && pair_end - v > 2 && (hi = hex_value(v[1])) >= 0 && (lo = hex_value(v[2])) >= 0) {
+                    out[len++] = (char)(hi << 4 | lo);
+                    v += 2;
+                } else {
+                    out[len++] = *v == '+' ? ' ' : *v;
+                }
+            }
+            out[len] = '\0';
+            return (int)len;
+        }
+        p = amp ? amp + 1 : NULL;
+    }
+    return -1;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file httpd.h
+ * @brief Minimal HTTP/1.1 server on epoll event loops.
+ *
+ * Each worker thread runs its own epoll loop over its own listening socket;
+ * SO_REUSEPORT lets the kernel spread new connections across them, so the
+ * workers share nothing. Connections are non-blocking and kept alive, and
+ * pipelined requests are answered in order. Only bodiless GET and HEAD
+ * requests are accepted; that covers a query API and keeps the parser to
+ * the request line and two headers. A connection must deliver each complete
+ * request, and take its response, within ten seconds of connecting or of its
+ * previous request; idle and slow clients are closed after that.
+ *
+ * Handlers run on the worker threads and must be thread-safe.
+ */
+
+#ifndef HTTPD_H
+#define HTTPD_H
+
+#include <stddef.h>
+
+#include "outbuf.h"
+
+struct HttpRequest {
+    const char *path; // Target from its leading '/' up to '?'; not NUL-terminated
+    int path_len;
+    const char *query; // After '?', or NULL
+    int query_len;
+    int worker; // Index of the serving thread in [0, num_threads), for per-thread state
+};
+
+struct HttpResponse {
+    int status;               // 200 unless the handler changes it
+    const char *content_type; // "text/plain; charset=utf-8" unless the handler changes it
+    struct OutBuf *body;      // Empty on entry; reused between requests
+};
+
+typedef void (*http_handler_fn)(void *ctx, const struct HttpRequest *req, struct HttpResponse *res);
+
+struct HttpdConfig {
+    const char *address; // IPv4 address to bind, e.g. "127.0.0.1"
+    int port;
+    int num_threads;
+    http_handler_fn handler;
+    void *ctx;
+};
+
+// Serves until SIGINT or SIGTERM. Blocks those signals in the calling thread,
+// which waits for them while the workers serve. Returns 0 after a clean
+// shutdown, -1 if the server could not start.
+int httpd_run(const struct HttpdConfig *config);
+
+// Copies the percent-decoded value of a query parameter into out as a C string.
+// Returns its length, or -1 when the parameter is absent or does not fit.
+int http_query_param(const struct HttpRequest *req, const char *name, char *out, size_t cap);
+
+#endif // HTTPD_H
@@ -0,0 +1,120 @@
+/**
+ * @file ingress.c
+ * @brief Solar ingress table and Sun-sign classification; see ingress.h.
+ */
+
+#include <math.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "ingress.h"
+#include "jday.h"
+
+#define INGRESS_YEARS (INGRESS_LAST_YEAR - INGRESS_FIRST_YEAR + 1)
+#define INGRESS_LANES 16       // Twelve ingresses padded to two SSE2 vectors
+#define INGRESS_NEVER 0x7FFF   // Padding key that no date reaches
+#define DATE_KEY(month, day) ((month) << 5 | (day)) // Orders dates within a year
+#define SIGN_CAPRICORN 9       // Sign on 1 January; Capricorn ingress is 20-23 December
+
+#define RAD_PER_DEG 0.017453292519943295
+
+// Ingress keys per year, ascending: lane k is the date the Sun enters sign
+// (SIGN_CAPRICORN + k + 1) % 12. The extra last row stands for every year
+// outside the table; its keys are all 0, so all sixteen lanes count as passed.
+static int16_t ingress_keys[INGRESS_YEARS + 1][INGRESS_LANES];
+
+// Sign after a number of passed lanes; 13-16 only occur on the out-of-range row.
+static int8_t passed_sign[INGRESS_LANES + 1];
+
+double ingress_sun_longitude(double jd_tt) {
+    double t = (jd_tt - 2451545.0) / 36525.0;
+    double mean_longitude = 280.46646 + 36000.76983 * t + 0.0003032 * t * t;
+    double anomaly = (357.52911 + 35999.05029 * t - 0.0001537 * t * t) * RAD_PER_DEG;
+    double center = (1.914602 - 0.004817 * t - 0.000014 * t * t) * sin(anomaly)
+                  + (0.019993 - 0.000101 * t) * sin(2 * anomaly)
+                  + 0.000289 * sin(3 * anomaly);
+    // General precession in longitude takes the mean equinox of date back to J2000.
+    double precession = 1.3969713 * t + 0.000308647 * t * t;
+    double longitude = fmod(mean_longitude + center - precession, 360.0);
+    return longitude < 0 ? longitude + 360.0 : longitude;
+}
+
+// Sign at 0h UT on a civil day, the instant Horizons reports for a date.
+static int sign_at_midnight(long jdn) {
+    return (int)(ingress_sun_longitude(jd_ut_to_tt(jdn - 0.5)) / 30.0);
+}
+
+void ingress_init(void) {
+    for (int y = 0; y < INGRESS_YEARS; y++) {
+        long first = jd_from_civil(INGRESS_FIRST_YEAR + y, 1, 1);
+        long last = jd_from_civil(INGRESS_FIRST_YEAR + y, 12, 31);
+        int lane = 0, sign = sign_at_midnight(first);
+        for (long jdn = first + 1; jdn <= last && lane < 12; jdn++) {
+            int next = sign_at_midnight(jdn);
+            if (next == sign) continue;
+            int year, month, day;
+            jd_to_civil(jdn, &year, &month, &day);
+            ingress_keys[y][lane++] = (int16_t)DATE_KEY(month, day);
+            sign = next;
+        }
+        for (; lane < INGRESS_LANES; lane++) ingress_keys[y][lane] = INGRESS_NEVER;
+    }
+    memset(ingress_keys[INGRESS_YEARS], 0, sizeof(ingress_keys[INGRESS_YEARS]));
+
+    for (int p = 0; p <= INGRESS_LANES; p++) {
+        passed_sign[p] = (int8_t)(p <= 12 ? (SIGN_CAPRICORN + p) % 12 : -1);
+    }
+}
+
+// Number of a year's ingress lanes on or before a date, 0-12, or 16 outside the table.
+static inline int ingress_passed(int year, int month, int day) {
+    // Unsigned wrap sends years before the table past its end as well.
+    unsigned row = (unsigned)(year - INGRESS_FIRST_YEAR);
+    row = row < INGRESS_YEARS ? row : INGRESS_YEARS;
+    const int16_t *keys = ingress_keys[row];
+    int key = DATE_KEY(month, day);
+#ifdef __SSE2__
+    // Lanes whose ingress is still ahead form a suffix, so the first of them
+    // is the count of passed lanes. Bit 16 bounds the scan when all have passed.
+    __m128i date = _mm_set1_epi16((short)key);
+    __m128i ahead_lo = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *)keys), date);
+    __m128i ahead_hi = _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *)(keys + 8)), date);
+    unsigned ahead = (unsigned)_mm_movemask_epi8(_mm_packs_epi16(ahead_lo, ahead_hi));
+    return __builtin_ctz(ahead | 1u << INGRESS_LANES);
+#else
+    int passed = 0;
+    for (int k = 0; k < INGRESS_LANES; k++) passed += key >= keys[k];
+    return passed;
+#endif
+}
+
+int ingress_sign(int year, int month, int day) {
+    return passed_sign[ingress_passed(year, month, day)];
+}
+
+void ingress_sign_records(const struct UserRecord *records, size_t count, int8_t *signs) {
+    for (size_t i = 0; i < count; i++) {
+        signs[i] = passed_sign[ingress_passed(records[i].year, records[i].month, records[i].day)];
+    }
+}
+
+void ingress_count_records(const struct UserRecord *records, size_t count, uint64_t counts[13]) {
+    // Four interleaved tallies, so consecutive equal signs do not serialise on one counter.
+    uint64_t tally[4][INGRESS_LANES + 1];
+    memset(tally, 0, sizeof(tally));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        tally[0][ingress_passed(records[i].year, records[i].month, records[i].day)]++;
+        tally[1][ingress_passed(records[i + 1].year, records[i + 1].month, records[i + 1].day)]++;
+        tally[2][ingress_passed(records[i + 2].year, records[i + 2].month, records[i + 2].day)]++;
+        tally[3][ingress_passed(records[i + 3].year, records[i + 3].month, records[i + 3].day)]++;
+    }
+    for (; i < count; i++) tally[0][ingress_passed(records[i].year, records[i].month, records[i].day)]++;
+
+    for (int p = 0; p <= INGRESS_LANES; p++) {
+        uint64_t n = tally[0][p] + tally[1][p] + tally[2][p] + tally[3][p];
+        counts[passed_sign[p] < 0 ? INGRESS_NO_SIGN : passed_sign[p]] += n;
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * @file ingress.h
+ * @brief Sun signs of calendar dates from a precomputed solar ingress table.
+ *
+ * For every year from INGRESS_FIRST_YEAR to INGRESS_LAST_YEAR the table holds
+ * the twelve dates on which the Sun enters a new sign, taken at 0h UT like
+ * the Horizons vectors the rest of the program reads (the solar theory runs
+ * on TT, so each midnight is shifted by Delta-T first). Positions come from a
+ * low-precision analytic solar theory (Meeus, Astronomical Algorithms ch. 25,
+ * about 0.01 degrees) reduced to the J2000 ecliptic, the frame Horizons
+ * reports in. An ingress lands within about a quarter of an hour of the
+ * ephemeris time, so a date can only differ from Horizons when an ingress
+ * falls that close to midnight.
+ *
+ * A date is classified by comparing its month and day against its year's
+ * twelve ingress dates at once (SSE2 where available) and counting how many
+ * have passed. This needs no branches and no per-date ephemeris work.
+ */
+
+#ifndef INGRESS_H
+#define INGRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "records.h"
+
+#define INGRESS_FIRST_YEAR 1900
+#define INGRESS_LAST_YEAR  2100
+#define INGRESS_NO_SIGN    12 // Histogram slot and label for dates outside the table
+
+// Fills the ingress table. Call once before any other ingress function.
+void ingress_init(void);
+
+// Geometric ecliptic longitude of the Sun (J2000 frame, degrees in [0, 360))
+// at a TT Julian Date, from the low-precision theory the table is built from.
+double ingress_sun_longitude(double jd_tt);
+
+// Sun sign 0-11 of a calendar date, or -1 outside the table's years.
+int ingress_sign(int year, int month, int day);
+
+// Writes the sign of each record's birth date to signs[i], -1 outside the table's years.
+void ingress_sign_records(const struct UserRecord *records, size_t count, int8_t *signs);
+
+// Adds the sign counts of the records' birth dates to counts[0-11] and the
+// dates outside the table to counts[INGRESS_NO_SIGN].
+void ingress_count_records(const struct UserRecord *records, size_t count, uint64_t counts[13]);
+
+#endif // INGRESS_H
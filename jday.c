@@ -0,0 +1,140 @@
+/**
+ * @file jday.c
+ * @brief Julian Day Number calendar and time core; see jday.h.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <time.h>
+
+#include "jday.h"
+
+// Observed TT - UT in seconds at 5-year steps from 1900.0 (IERS / Espenak & Meeus).
+static const double delta_t_table[] = {
+    -2.79, 3.86, 10.46, 17.20, 21.16, 23.62, 24.02, 23.93, 24.33, 26.77, // 1900-1945
+    29.15, 31.07, 33.15, 35.73, 40.18, 45.48, 50.54, 54.34, 56.86, 60.78, // 1950-1995
+    63.83, 64.69, 66.07, 67.64, 69.36, 69.20                              // 2000-2025
+};
+#define DELTA_T_FIRST_YEAR 1900
+#define DELTA_T_STEP_YEARS 5
+#define DELTA_T_ENTRIES (int)(sizeof(delta_t_table) / sizeof(delta_t_table[0]))
+
+// Floor division for possibly negative numerators.
+static inline long floor_div(long a, long b) {
+    long q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+long jd_from_civil(int year, int month, int day) {
+    // Shift the year to start in March so the leap day is last.
+    long y = year - (month <= 2);
+    long era = floor_div(y, 400);
+    long yoe = y - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe + 1721120L;
+}
+
+void jd_to_civil(long jdn, int *year, int *month, int *day) {
+    long z = jdn - 1721120L;
+    long era = floor_div(z, 146097);
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+int jd_valid_civil(int year, int month, int day) {
+    if (month < 1 || month > 12 || day < 1) return 0;
+    int y, m, d;
+    jd_to_civil(jd_from_civil(year, month, day), &y, &m, &d);
+    return y == year && m == month && d == day;
+}
+
+void jd_format(long jdn, char out[11]) {
+    int year, month, day;
+    jd_to_civil(jdn, &year, &month, &day);
+    jd_format_civil(year, month, day, out);
+}
+
+void jd_format_civil(int year, int month, int day, char out[11]) {
+    out[0] = (char)('0' + year / 1000 % 10);
+    out[1] = (char)('0' + year / 100 % 10);
+    out[2] = (char)('0' + year / 10 % 10);
+    out[3] = (char)('0' + year % 10);
+    out[4] = '-';
+    out[5] = (char)('0' + month / 10);
+    out[6] = (char)('0' + month % 10);
+    out[7] = '-';
+    out[8] = (char)('0' + day / 10);
+    out[9] = (char)('0' + day % 10);
+    out[10] = '\0';
+}
+
+int jd_parse(const char *text, long *jdn) {
+    int year, month, day, len = 0;
+    if (sscanf(text, "%4d-%2d-%2d%n", &year, &month, &day, &len) != 3 || text[len] != '\0' || len != 10 ||
+        !jd_valid_civil(year, month, day)) {
+        return -1;
+    }
+    *jdn = jd_from_civil(year, month, day);
+    return 0;
+}
+
+long jd_today_utc(void) {
+    return jd_now_utc(NULL);
+}
+
+long jd_now_utc(double *day_fraction) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    long days = floor_div((long)ts.tv_sec, 86400);
+    if (day_fraction) *day_fraction = ((ts.tv_sec - days * 86400) + ts.tv_nsec * 1e-9) / 86400.0;
+    return days + JD_UNIX_EPOCH;
+}
+
+double jd_delta_t(double jd_ut) {
+    double year = 2000.0 + (jd_ut - 2451544.5) / 365.2425;
+    double pos = (year - DELTA_T_FIRST_YEAR) / DELTA_T_STEP_YEARS;
+
+    if (pos >= 0 && pos < DELTA_T_ENTRIES - 1) {
+        int i = (int)pos;
+        return delta_t_table[i] + (pos - i) * (delta_t_table[i + 1] - delta_t_table[i]);
+    }
+    if (pos >= 0 && year < 2050) {
+        // Delta-T has been flat since 2015; published predictions stay within a
+        // second of the last observed value for decades.
+        return delta_t_table[DELTA_T_ENTRIES - 1];
+    }
+    // Long-term parabola (Morrison & Stephenson) for anything further out.
+    double u = (year - 1820) / 100;
+    return -20 + 32 * u * u;
+}
+
+double jd_ut_to_tt(double jd_ut) {
+    return jd_ut + jd_delta_t(jd_ut) / 86400.0;
+}
+
+void jd_range(long first, int n, long *out) {
+    for (int i = 0; i < n; i++) out[i] = first + i;
+}
+
+void jd_to_civil_n(const long *jdn, int n, int *year, int *month, int *day) {
+    // Same arithmetic as jd_to_civil(), restricted to dates after 1 March 0000
+    // so every division is on non-negative values and no branch is needed.
+    for (int i = 0; i < n; i++) {
+        long doe_all = jdn[i] - 1721120L;
+        long era = doe_all / 146097;
+        long doe = doe_all - era * 146097;
+        long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long mp = (5 * doy + 2) / 153;
+        long m = mp + 3 - 12 * (mp >= 10);
+        day[i] = (int)(doy - (153 * mp + 2) / 5 + 1);
+        month[i] = (int)m;
+        year[i] = (int)(yoe + era * 400 + (m <= 2));
+    }
+}
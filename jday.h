@@ -0,0 +1,59 @@
+/**
+ * @file jday.h
+ * @brief Calendar and time core built on integer Julian Day Numbers.
+ *
+ * All date arithmetic in the program goes through here instead of mktime(),
+ * localtime() and strftime(). The functions are pure integer arithmetic on
+ * the proleptic Gregorian calendar, touch no timezone state and keep no
+ * static storage, so they are safe to call from any thread.
+ *
+ * A Julian Day Number (JDN) names a civil day; the day starts at JD
+ * jdn - 0.5 (midnight). "Today" is the current UTC date, and a civil date
+ * means 0h UT: Horizons requests ask for UT explicitly, and the analytic
+ * solar theory in ingress.c, which runs on TT, converts with jd_ut_to_tt().
+ */
+
+#ifndef JDAY_H
+#define JDAY_H
+
+#define JD_UNIX_EPOCH 2440588L // JDN of 1970-01-01
+
+// JDN of a Gregorian calendar date. Month and day are not range-checked.
+long jd_from_civil(int year, int month, int day);
+
+// Gregorian calendar date of a JDN.
+void jd_to_civil(long jdn, int *year, int *month, int *day);
+
+// Returns 1 when year-month-day names a real calendar date, else 0.
+int jd_valid_civil(int year, int month, int day);
+
+// Writes a JDN as YYYY-MM-DD into out (at least 11 bytes).
+void jd_format(long jdn, char out[11]);
+
+// As jd_format, for a date already split by jd_to_civil() or jd_to_civil_n().
+void jd_format_civil(int year, int month, int day, char out[11]);
+
+// Parses a YYYY-MM-DD date. Returns 0 and sets *jdn, or -1 if text is not a real date.
+int jd_parse(const char *text, long *jdn);
+
+// Today's JDN in UTC. jd_now_utc() also sets *day_fraction (if not NULL) to
+// the part of the day since 0h UT, taken from the same clock reading.
+long jd_today_utc(void);
+long jd_now_utc(double *day_fraction);
+
+// TT - UT in seconds for a Julian Date: interpolated from observed values for
+// 1900-2025, held at the 2025 value until 2050, and the Morrison & Stephenson
+// long-term parabola outside that.
+double jd_delta_t(double jd_ut);
+
+// Converts a UT Julian Date to TT.
+double jd_ut_to_tt(double jd_ut);
+
+// Fills out[i] = first + i for n consecutive days.
+void jd_range(long first, int n, long *out);
+
+// Converts n JDNs to calendar dates; a straight-line loop the compiler can
+// vectorize. Only valid from 0000-03-01 (JDN 1721120) onwards.
+void jd_to_civil_n(const long *jdn, int n, int *year, int *month, int *day);
+
+#endif // JDAY_H
@@ -0,0 +1,124 @@
+/**
+ * @file jsonw.c
+ * @brief Streaming JSON writer; see jsonw.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "jsonw.h"
+
+void jsonw_init(struct JsonWriter *w, struct OutBuf *out) {
+    w->out = out;
+    w->depth = 0;
+    w->has_members = 0;
+    w->after_key = 0;
+}
+
+// Emits the separator owed before a new value in the current container.
+static void begin_value(struct JsonWriter *w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return;
+    }
+    uint64_t bit = (uint64_t)1 << (w->depth & (JSONW_MAX_DEPTH - 1));
+    if (w->has_members & bit) outbuf_putc(w->out, ',');
+    w->has_members |= bit;
+}
+
+static void open_container(struct JsonWriter *w, char c) {
+    begin_value(w);
+    outbuf_putc(w->out, c);
+    w->depth++;
+    w->has_members &= ~((uint64_t)1 << (w->depth & (JSONW_MAX_DEPTH - 1)));
+}
+
+static void close_container(struct JsonWriter *w, char c) {
+    w->depth--;
+    outbuf_putc(w->out, c);
+}
+
+void jsonw_begin_object(struct JsonWriter *w) { open_container(w, '{'); }
+void jsonw_end_object(struct JsonWriter *w) { close_container(w, '}'); }
+void jsonw_begin_array(struct JsonWriter *w) { open_container(w, '['); }
+void jsonw_end_array(struct JsonWriter *w) { close_container(w, ']'); }
+
+// Writes a quoted, escaped string without separator handling.
+static void put_string(struct OutBuf *out, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    outbuf_putc(out, '"');
+    size_t run = 0; // Start of the pending stretch that needs no escaping
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        outbuf_write(out, s + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"':  outbuf_write(out, "\\\"", 2); break;
+        case '\\': outbuf_write(out, "\\\\", 2); break;
+        case '\n': outbuf_write(out, "\\n", 2); break;
+        case '\r': outbuf_write(out, "\\r", 2); break;
+        case '\t': outbuf_write(out, "\\t", 2); break;
+        default: {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            outbuf_write(out, esc, sizeof(esc));
+        }
+        }
+    }
+    outbuf_write(out, s + run, n - run);
+    outbuf_putc(out, '"');
+}
+
+void jsonw_key(struct JsonWriter *w, const char *key) {
+    begin_value(w);
+    put_string(w->out, key, strlen(key));
+    outbuf_putc(w->out, ':');
+    w->after_key = 1;
+}
+
+void jsonw_string(struct JsonWriter *w, const char *s) {
+    jsonw_string_n(w, s, strlen(s));
+}
+
+void jsonw_string_n(struct JsonWriter *w, const char *s, size_t n) {
+    begin_value(w);
+    put_string(w->out, s, n);
+}
+
+// Appends the decimal digits of v, which must be non-negative.
+static void put_unsigned(struct OutBuf *out, unsigned long long v) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    outbuf_write(out, digits + sizeof(digits) - n, n);
+}
+
+void jsonw_int(struct JsonWriter *w, long value) {
+    begin_value(w);
+    if (value < 0) outbuf_putc(w->out, '-');
+    put_unsigned(w->out, value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value);
+}
+
+void jsonw_fixed(struct JsonWriter *w, double value, int decimals) {
+    if (!isfinite(value)) {
+        jsonw_null(w);
+        return;
+    }
+    begin_value(w);
+    // JSON has no use for a negative zero, so values that round to zero lose their sign.
+    outbuf_fixed_unsigned_zero(w->out, value, decimals, 0);
+}
+
+void jsonw_bool(struct JsonWriter *w, int value) {
+    begin_value(w);
+    if (value) outbuf_write(w->out, "true", 4);
+    else outbuf_write(w->out, "false", 5);
+}
+
+void jsonw_null(struct JsonWriter *w) {
+    begin_value(w);
+    outbuf_write(w->out, "null", 4);
+}
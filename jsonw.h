@@ -0,0 +1,47 @@
+/**
+ * @file jsonw.h
+ * @brief Streaming JSON writer that appends straight into an OutBuf.
+ *
+ * No document tree is built: each call emits its token immediately, and the
+ * writer only tracks whether the current object or array needs a comma
+ * before the next member. Rendering into a reused OutBuf therefore allocates
+ * nothing once the buffer has grown to the size of a typical record.
+ * Nesting deeper than JSONW_MAX_DEPTH is not supported.
+ */
+
+#ifndef JSONW_H
+#define JSONW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "outbuf.h"
+
+#define JSONW_MAX_DEPTH 64
+
+struct JsonWriter {
+    struct OutBuf *out;
+    int depth;
+    uint64_t has_members; // Bit d set once the container at depth d has a member
+    int after_key;        // The next value completes a key/value pair
+};
+
+void jsonw_init(struct JsonWriter *w, struct OutBuf *out);
+
+void jsonw_begin_object(struct JsonWriter *w);
+void jsonw_end_object(struct JsonWriter *w);
+void jsonw_begin_array(struct JsonWriter *w);
+void jsonw_end_array(struct JsonWriter *w);
+
+// Starts a member of the current object; the next call writes its value.
+void jsonw_key(struct JsonWriter *w, const char *key);
+
+void jsonw_string(struct JsonWriter *w, const char *s);
+void jsonw_string_n(struct JsonWriter *w, const char *s, size_t n);
+void jsonw_int(struct JsonWriter *w, long value);
+// Writes value rounded to a fixed number of decimals (0-9); null when not finite.
+void jsonw_fixed(struct JsonWriter *w, double value, int decimals);
+void jsonw_bool(struct JsonWriter *w, int value);
+void jsonw_null(struct JsonWriter *w);
+
+#endif // JSONW_H
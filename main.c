@@ -8,7 +8,7 @@
  * current biorhythm cycles.
  *
  * Compilation:
- * gcc main.c -o nasa_forecast -lcurl -ljansson -lm
+ * make (see Makefile for the source list and libraries)
  */
 
 #define _GNU_SOURCE
@@ -18,379 +18,2166 @@
 #include <curl/curl.h>
 #include <jansson.h>
 #include <math.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
 #include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bam.h"
+#include "bioindex.h"
+#include "colexport.h"
+#include "biorhythm.h"
+#include "ephem.h"
+#include "forecast.h"
+#include "gzstream.h"
+#include "horizons.h"
+#include "httpd.h"
+#include "ingress.h"
+#include "jsonw.h"
+#include "jday.h"
+#include "ordered.h"
+#include "outbuf.h"
+#include "pool.h"
+#include "records.h"
+#include "shmcache.h"
+#include "snapshot.h"
+#include "stopwatch.h"
+#include "template.h"
 
 // --- Constants ---
 #define AU_TO_KM 149597870.7
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
-#define ORB_CONJ_OPP 8.0 // Orb of 8 degrees for Conjunction and Opposition
-#define ORB_TRINE_SQR_SEX 6.0 // Orb of 6 degrees for Trine, Square, and Sextile
 
 // --- ANSI Color Codes for Highlighting ---
 #define COLOR_GREEN   "\x1b[32m" // For positive states
 #define COLOR_RED     "\x1b[31m" // For negative states
 #define COLOR_RESET   "\x1b[0m"
 
-// Struct to hold the response data from a curl request.
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
-
-// Struct to hold planetary data and astrological keywords.
+// Presentation view of a body: display name, Horizons id and astrological keyword.
+// Positions are kept separately in a struct PlanetSeries.
 struct Planet {
     const char *name;
     const char *id;
-    double longitude;
     const char *keyword; // e.g., "energy", "love", "communication"
 };
 
-// --- Astrological Keywords ---
-const char* planet_keywords[] = {
-    "your identity and ego", "your emotions and security", "communication and thinking",
-    "love and money", "energy and drive", "luck and expansion",
-    "discipline and responsibility", "change and surprise", "dreams and intuition",
-    "power and transformation"
+const char* sun_sign_names[] = {"Aries", "Taurus", "Gemini", "Cancer", "Leo", "Virgo", "Libra", "Scorpio", "Sagittarius", "Capricorn", "Aquarius", "Pisces"};
+
+// Machine-readable names, indexed by enum Aspect and enum ForecastOutlook.
+const char* aspect_names[] = {"none", "conjunction", "opposition", "trine", "square", "sextile"};
+const char* outlook_names[] = {"mixed", "positive", "challenging"};
+
+// Report formats selectable with --format.
+enum OutputFormat {
+    FORMAT_TEXT, FORMAT_JSON, FORMAT_NDJSON
 };
 
-const char* house_keywords[] = {
-    "Self, Identity, and Appearance", "Money and Possessions", "Communication and Local Travel",
-    "Home and Family", "Creativity and Romance", "Health and Daily Work",
-    "Partnerships and Marriage", "Shared Resources and Transformation", "Philosophy and Long-Distance Travel",
-    "Career and Public Reputation", "Friendships and Social Groups", "Spirituality and the Subconscious"
+// --- Report Templates ---
+// Built-in wording of the text report; --templates=FILE overrides any of these keys.
+static const char *const default_templates[][2] = {
+    {"forecast.header", "\n--- Horoscope Forecast for {sign} ---\n"},
+    {"forecast.transits", "\n--- Planetary Transits by House ---\n"},
+    {"forecast.transit", "- {planet} is transiting your {house}{ordinal} House of {house_keyword}, affecting {keyword}.\n"},
+    {"forecast.aspects", "\n--- Major Aspects to your Sun ---\n"},
+    {"forecast.aspect.conjunction", "- {planet} is in conjunction with your Sun, amplifying {keyword}.\n"},
+    {"forecast.aspect.opposition", "- {planet} opposes your Sun, creating tension with {keyword}.\n"},
+    {"forecast.aspect.trine", "- {planet} forms a harmonious trine with your Sun, supporting {keyword}.\n"},
+    {"forecast.aspect.square", "- {planet} forms a challenging square with your Sun, creating friction with {keyword}.\n"},
+    {"forecast.aspect.sextile", "- {planet} forms a gentle sextile with your Sun, offering opportunities for {keyword}.\n"},
+    {"forecast.no_aspects", "A quiet day. No major aspects are affecting your Sun sign today.\n"},
+    {"forecast.footer", "-------------------------------------\n"},
+    {"report.header", "\n--- Your Personal Forecast ---\n\nBiorhythms:\n"},
+    {"report.summary", "\nSummary: "},
+    {"report.outlook.positive", "Astrologically, today looks to be a positive day, with opportunities for growth and harmony. "},
+    {"report.outlook.challenging", "Astrologically, you may face some challenges today, requiring patience and careful thought. "},
+    {"report.outlook.mixed", "Astrologically, today brings a mix of opportunities and challenges, requiring balance. "},
+    {"report.focus", "The main focus is on the area of {house_keyword}. "},
+    {"report.biorhythm", "\nFrom a biorhythm perspective: "},
+    {"report.physical.high", COLOR_GREEN "Physically, you should be feeling strong and energetic. " COLOR_RESET},
+    {"report.physical.low", COLOR_RED "Physically, you may feel low on energy. " COLOR_RESET},
+    {"report.physical.normal", "Physically, it's a relatively normal day. "},
+    {"report.emotional.high", COLOR_GREEN "Emotionally, you're likely feeling positive and creative. " COLOR_RESET},
+    {"report.emotional.low", COLOR_RED "Emotionally, you may be feeling sensitive or withdrawn. " COLOR_RESET},
+    {"report.emotional.normal", "Emotionally, things are on an even keel. "},
+    {"report.intellectual.high", COLOR_GREEN "Intellectually, your mind is sharp and clear. " COLOR_RESET},
+    {"report.intellectual.low", COLOR_RED "Intellectually, it might be a good day for rest rather than complex tasks. " COLOR_RESET},
+    {"report.intellectual.normal", "Intellectually, your focus is stable. "},
+    {"report.footer", "\n----------------------------\n"},
+
+    // --- Astrological Keywords ---
+    {"keyword.Sun", "your identity and ego"}, {"keyword.Moon", "your emotions and security"},
+    {"keyword.Mercury", "communication and thinking"}, {"keyword.Venus", "love and money"},
+    {"keyword.Mars", "energy and drive"}, {"keyword.Jupiter", "luck and expansion"},
+    {"keyword.Saturn", "discipline and responsibility"}, {"keyword.Uranus", "change and surprise"},
+    {"keyword.Neptune", "dreams and intuition"}, {"keyword.Pluto", "power and transformation"},
+    {"house.1", "Self, Identity, and Appearance"}, {"house.2", "Money and Possessions"},
+    {"house.3", "Communication and Local Travel"}, {"house.4", "Home and Family"},
+    {"house.5", "Creativity and Romance"}, {"house.6", "Health and Daily Work"},
+    {"house.7", "Partnerships and Marriage"}, {"house.8", "Shared Resources and Transformation"},
+    {"house.9", "Philosophy and Long-Distance Travel"}, {"house.10", "Career and Public Reputation"},
+    {"house.11", "Friendships and Social Groups"}, {"house.12", "Spirituality and the Subconscious"}
 };
 
-// Callback function for libcurl
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if (ptr == NULL) return 0;
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
-    return realsize;
-}
-
-// Parses planetary data from NASA API response
-int parse_planet_data(const char *json_text, double *longitude) {
-    json_error_t error;
-    json_t *root = json_loads(json_text, 0, &error);
-    if (!root) return -1;
-    json_t *result = json_object_get(root, "result");
-    if (!json_is_string(result)) { json_decref(root); return -1; }
-    const char *result_text = json_string_value(result);
-    const char *data_start = strstr(result_text, "$$SOE");
-    if (!data_start) { json_decref(root); return -1; }
-    const char *x_ptr = strstr(data_start, "X =");
-    const char *y_ptr = strstr(data_start, "Y =");
-    if (!(x_ptr && y_ptr)) { json_decref(root); return -1; }
-    double x_km, y_km;
-    sscanf(x_ptr, "X =%lf", &x_km);
-    sscanf(y_ptr, "Y =%lf", &y_km);
-    
-    double longitude_rad = atan2(y_km, x_km);
-    *longitude = longitude_rad * (180.0 / M_PI);
-    if (*longitude < 0) *longitude += 360;
+// Biorhythm summary levels, indexed like the templates: above +50, below -50, otherwise.
+enum { BIO_HIGH, BIO_LOW, BIO_NORMAL };
+
+// The compiled templates the renderers use, resolved from the pack once at startup.
+struct ReportTemplates {
+    const struct Template *forecast_header, *transits, *transit, *aspects, *aspect[6], *no_aspects, *forecast_footer;
+    const struct Template *report_header, *summary, *outlook[3], *focus, *biorhythm, *report_footer;
+    const struct Template *physical[3], *emotional[3], *intellectual[3];
+    const char *house_keyword[12];
+};
+
+static struct TemplatePack template_pack;
+static struct ReportTemplates tpl;
+
+// The same wording without terminal colors, for reports served over HTTP.
+static struct TemplatePack plain_pack;
+static struct ReportTemplates plain_tpl;
+
+// Finds a required template, reporting the key when it is missing.
+static const struct Template *require_template(const struct TemplatePack *pack, const char *key) {
+    const struct Template *t = template_pack_find(pack, key);
+    if (!t) printf("Error: Template '%s' is missing.\n", key);
+    return t;
+}
+
+// Looks up a slot-free template as plain text.
+static const char *require_text(const struct TemplatePack *pack, const char *key) {
+    const struct Template *t = require_template(pack, key);
+    const char *text = t ? template_literal(t) : NULL;
+    if (t && !text) printf("Error: Template '%s' must not contain slots.\n", key);
+    return text;
+}
+
+// Resolves a template per level, e.g. report.physical.high/low/normal.
+static int require_levels(const struct TemplatePack *pack, const struct Template *out[3], const char *prefix) {
+    static const char *const level_names[] = {"high", "low", "normal"};
+    int ok = 1;
+    for (int l = 0; l < 3; l++) {
+        char key[64];
+        snprintf(key, sizeof(key), "%s.%s", prefix, level_names[l]);
+        ok &= (out[l] = require_template(pack, key)) != NULL;
+    }
+    return ok;
+}
 
-    json_decref(root);
+// Compiles the built-in templates into pack and overlays the optional pack file.
+static int build_template_pack(struct TemplatePack *pack, const char *path) {
+    template_pack_init(pack);
+    for (size_t i = 0; i < sizeof(default_templates) / sizeof(default_templates[0]); i++) {
+        if (template_pack_set(pack, default_templates[i][0], default_templates[i][1]) != 0) {
+            printf("Error: Out of memory.\n");
+            return -1;
+        }
+    }
+    int error_line;
+    if (path && template_pack_load(pack, path, &error_line) != 0) {
+        if (error_line) printf("Error: %s:%d: Malformed template line.\n", path, error_line);
+        else printf("Error: Could not read %s.\n", path);
+        return -1;
+    }
     return 0;
 }
 
+// Resolves everything the renderers need from a pack. Returns 1 when all keys are present.
+static int resolve_templates(struct ReportTemplates *t, const struct TemplatePack *pack) {
+    char key[64];
+    int ok = 1;
+    ok &= (t->forecast_header = require_template(pack, "forecast.header")) != NULL;
+    ok &= (t->transits = require_template(pack, "forecast.transits")) != NULL;
+    ok &= (t->transit = require_template(pack, "forecast.transit")) != NULL;
+    ok &= (t->aspects = require_template(pack, "forecast.aspects")) != NULL;
+    for (int a = ASPECT_CONJUNCTION; a <= ASPECT_SEXTILE; a++) {
+        snprintf(key, sizeof(key), "forecast.aspect.%s", aspect_names[a]);
+        ok &= (t->aspect[a] = require_template(pack, key)) != NULL;
+    }
+    ok &= (t->no_aspects = require_template(pack, "forecast.no_aspects")) != NULL;
+    ok &= (t->forecast_footer = require_template(pack, "forecast.footer")) != NULL;
+    ok &= (t->report_header = require_template(pack, "report.header")) != NULL;
+    ok &= (t->summary = require_template(pack, "report.summary")) != NULL;
+    for (int o = OUTLOOK_MIXED; o <= OUTLOOK_CHALLENGING; o++) {
+        snprintf(key, sizeof(key), "report.outlook.%s", outlook_names[o]);
+        ok &= (t->outlook[o] = require_template(pack, key)) != NULL;
+    }
+    ok &= (t->focus = require_template(pack, "report.focus")) != NULL;
+    ok &= (t->biorhythm = require_template(pack, "report.biorhythm")) != NULL;
+    ok &= require_levels(pack, t->physical, "report.physical");
+    ok &= require_levels(pack, t->emotional, "report.emotional");
+    ok &= require_levels(pack, t->intellectual, "report.intellectual");
+    ok &= (t->report_footer = require_template(pack, "report.footer")) != NULL;
+    for (int h = 0; h < 12; h++) {
+        snprintf(key, sizeof(key), "house.%d", h + 1);
+        ok &= (t->house_keyword[h] = require_text(pack, key)) != NULL;
+    }
+    return ok;
+}
+
+// Builds the terminal and the plain template sets from the built-in templates
+// and the optional pack file, and resolves each planet's keyword.
+int load_report_templates(const char *path, struct Planet planets[], int num_planets) {
+    if (build_template_pack(&template_pack, path) != 0 || !resolve_templates(&tpl, &template_pack)) return -1;
+    if (template_pack_copy(&plain_pack, &template_pack) != 0) {
+        printf("Error: Out of memory.\n");
+        return -1;
+    }
+    template_pack_strip_ansi(&plain_pack);
+    if (!resolve_templates(&plain_tpl, &plain_pack)) return -1;
+
+    // Both sets share the planet keywords, so they come from the plain pack.
+    char key[64];
+    int ok = 1;
+    for (int i = 0; i < num_planets; i++) {
+        snprintf(key, sizeof(key), "keyword.%s", planets[i].name);
+        ok &= (planets[i].keyword = require_text(&plain_pack, key)) != NULL;
+    }
+    return ok ? 0 : -1;
+}
+
 // Determines the zodiac sign index (0-11) from a longitude
-int get_zodiac_index(double longitude_degrees) {
-    return (int)floor(longitude_degrees / 30.0);
+int get_zodiac_index(bam32_t longitude) {
+    return bam_sign_index(longitude);
 }
 
-// Prints a single bar for the biorhythm chart
-void print_biorhythm_bar(double value) {
-    int bar_width = 20;
-    int center = bar_width;
-    int scaled_value = (int)(value / 100.0 * bar_width);
+// --- Biorhythm Bars ---
+// A bar is "[", 20 cells left of the axis, "|", 20 cells right of it and "]".
+// All 41 possible bars are rendered once at startup and copied whole.
+#define BAR_WIDTH 20
+#define BAR_CHARS (2 * BAR_WIDTH + 3)
 
-    printf("[");
-    if (scaled_value >= 0) {
-        for(int i=0; i<center; ++i) printf(" ");
-        printf("|");
-        for(int i=0; i<scaled_value; ++i) printf("+");
-        for(int i=0; i<bar_width - scaled_value; ++i) printf(" ");
-    } else {
-        for(int i=0; i<center + scaled_value; ++i) printf(" ");
-        for(int i=0; i<-scaled_value; ++i) printf("-");
-        printf("|");
-        for(int i=0; i<bar_width; ++i) printf(" ");
+static char bar_glyphs[2 * BAR_WIDTH + 1][BAR_CHARS];
+
+void init_bar_glyphs(void) {
+    for (int scaled_value = -BAR_WIDTH; scaled_value <= BAR_WIDTH; scaled_value++) {
+        char *bar = bar_glyphs[scaled_value + BAR_WIDTH];
+        memset(bar, ' ', BAR_CHARS);
+        bar[0] = '[';
+        bar[BAR_WIDTH + 1] = '|';
+        bar[BAR_CHARS - 1] = ']';
+        if (scaled_value >= 0) {
+            memset(bar + BAR_WIDTH + 2, '+', scaled_value);
+        } else {
+            memset(bar + BAR_WIDTH + 1 + scaled_value, '-', -scaled_value);
+        }
     }
-    printf("]");
 }
 
-// Generates and prints the detailed forecast
-void generate_forecast(struct Planet planets[], int num_planets, int sun_sign_idx) {
-    const char* sun_sign_names[] = {"Aries", "Taurus", "Gemini", "Cancer", "Leo", "Virgo", "Libra", "Scorpio", "Sagittarius", "Capricorn", "Aquarius", "Pisces"};
-    printf("\n--- Horoscope Forecast for %s ---\n", sun_sign_names[sun_sign_idx]);
-    
-    // --- House Transits Section ---
-    printf("\n--- Planetary Transits by House ---\n");
+// Appends a single bar for the biorhythm chart
+void print_biorhythm_bar(struct OutBuf *out, double value) {
+    int scaled_value = (int)(value / 100.0 * BAR_WIDTH);
+    if (scaled_value < -BAR_WIDTH) scaled_value = -BAR_WIDTH;
+    if (scaled_value > BAR_WIDTH) scaled_value = BAR_WIDTH;
+    outbuf_write(out, bar_glyphs[scaled_value + BAR_WIDTH], BAR_CHARS);
+}
+
+// Appends one labelled "NNN% [bar]" line
+void print_biorhythm_line(struct OutBuf *out, const char *label, double value) {
+    outbuf_puts(out, label);
+    outbuf_fixed(out, value, 0, 4);
+    outbuf_write(out, "% ", 2);
+    print_biorhythm_bar(out, value);
+    outbuf_putc(out, '\n');
+}
+
+// Index of the named body in the planet list, or -1
+int find_body(const struct Planet planets[], int num_planets, const char *name) {
     for (int i = 0; i < num_planets; i++) {
-        int planet_sign_idx = get_zodiac_index(planets[i].longitude);
-        // Calculate house number using Whole Sign House system
-        int house_num = (planet_sign_idx - sun_sign_idx + 12) % 12 + 1;
-        printf("- %s is transiting your %d%s House of %s, affecting %s.\n",
-               planets[i].name,
-               house_num,
-               (house_num==1)?"st":(house_num==2)?"nd":(house_num==3)?"rd":"th",
-               house_keywords[house_num - 1],
-               planets[i].keyword);
+        if (strcmp(planets[i].name, name) == 0) return i;
     }
+    return -1;
+}
 
-    // --- Major Aspects Section ---
-    printf("\n--- Major Aspects to your Sun ---\n");
-    double sun_sign_longitude = (sun_sign_idx * 30.0) + 15.0;
-    int aspects_found = 0;
-    for (int i = 0; i < num_planets; i++) {
-        double angle_diff = fabs(planets[i].longitude - sun_sign_longitude);
-        if (angle_diff > 180) angle_diff = 360 - angle_diff;
+// Counts whole days between a birth date and now
+long days_alive_today(int year, int month, int day) {
+    return jd_today_utc() - jd_from_civil(year, month, day);
+}
 
-        const char* aspect_text = NULL;
-        
-        if (angle_diff <= ORB_CONJ_OPP) {
-            aspect_text = "is in conjunction with your Sun, amplifying";
-        } else if (fabs(angle_diff - 180) <= ORB_CONJ_OPP) {
-            aspect_text = "opposes your Sun, creating tension with";
-        } else if (fabs(angle_diff - 120) <= ORB_TRINE_SQR_SEX) {
-            aspect_text = "forms a harmonious trine with your Sun, supporting";
-        } else if (fabs(angle_diff - 90) <= ORB_TRINE_SQR_SEX) {
-            aspect_text = "forms a challenging square with your Sun, creating friction with";
-        } else if (fabs(angle_diff - 60) <= ORB_TRINE_SQR_SEX) {
-            aspect_text = "forms a gentle sextile with your Sun, offering opportunities for";
-        }
+// Parses a population query such as "triple-high" or "physical:high,emotional:critical"
+// into a predicate. Returns 0 on success, -1 on an unknown term.
+int parse_population_query(const char *expr, struct BioPredicate *pred) {
+    static const char *cycle_names[] = {"physical", "emotional", "intellectual"};
+    static const char *level_names[] = {"high", "low", "critical"};
 
-        if (aspect_text) {
-            printf("- %s %s %s.\n", planets[i].name, aspect_text, planets[i].keyword);
-            aspects_found = 1;
+    bio_predicate_any(pred);
+    while (*expr) {
+        size_t len = strcspn(expr, ",");
+        int matched = 0;
+        for (int l = 0; l < 3 && !matched; l++) {
+            char term[32];
+            snprintf(term, sizeof(term), "triple-%s", level_names[l]);
+            if (len == strlen(term) && strncmp(expr, term, len) == 0) {
+                for (int c = 0; c < 3; c++) bio_predicate_require(pred, c, (enum BioLevel)l);
+                matched = 1;
+            }
+            for (int c = 0; c < 3 && !matched; c++) {
+                snprintf(term, sizeof(term), "%s:%s", cycle_names[c], level_names[l]);
+                if (len == strlen(term) && strncmp(expr, term, len) == 0) {
+                    bio_predicate_require(pred, c, (enum BioLevel)l);
+                    matched = 1;
+                }
+            }
         }
+        if (!matched) return -1;
+        expr += len;
+        if (*expr == ',') expr++;
     }
+    return 0;
+}
 
-    if (!aspects_found) {
-        printf("A quiet day. No major aspects are affecting your Sun sign today.\n");
+// Loads a record file on num_threads threads and reports the parse rate on stderr.
+int load_user_records(const char *path, struct RecordSet *users, int num_threads) {
+    double start = stopwatch_seconds();
+    if (records_load(path, users, num_threads) != 0) {
+        printf("Error: Could not read %s.\n", path);
+        return -1;
     }
-    printf("-------------------------------------\n");
+    double seconds = stopwatch_seconds() - start;
+    size_t rows = users->count + users->skipped;
+    fprintf(stderr, "Read %zu rows in %.1f ms (%.1f M rows/s on %d threads%s).\n", rows, seconds * 1e3,
+            seconds > 0 ? rows / seconds / 1e6 : 0.0, num_threads, users->mapped ? ", mapped" : "");
+    return 0;
 }
 
-// Generates a single, combined summary report
-void generate_final_report(struct Planet planets[], int num_planets, int sun_sign_idx, int year, int month, int day) {
-    int positive_aspects = 0;
-    int negative_aspects = 0;
-    const char* focus_house = NULL;
+// Answers a biorhythm query over every user in a record file for num_days days from today
+int run_population_query(const char *path, const char *query, int num_days, int num_threads) {
+    struct BioPredicate pred;
+    if (parse_population_query(query, &pred) != 0) {
+        printf("Error: Unknown population query '%s'.\n", query);
+        return 1;
+    }
 
-    double sun_sign_longitude = (sun_sign_idx * 30.0) + 15.0;
+    struct RecordSet users;
+    if (load_user_records(path, &users, num_threads) != 0) {
+        return 1;
+    }
 
-    for (int i = 0; i < num_planets; i++) {
-        double angle_diff = fabs(planets[i].longitude - sun_sign_longitude);
-        if (angle_diff > 180) angle_diff = 360 - angle_diff;
+    long *birth_days = malloc((users.count ? users.count : 1) * sizeof(*birth_days));
+    uint32_t *matches = malloc((users.count ? users.count : 1) * sizeof(*matches));
+    struct BioIndex index;
+    long today = jd_today_utc();
+    if (!birth_days || !matches) {
+        printf("Error: Out of memory.\n");
+        free(birth_days);
+        free(matches);
+        records_free(&users);
+        return 1;
+    }
+    for (size_t i = 0; i < users.count; i++) {
+        birth_days[i] = jd_from_civil(users.records[i].year, users.records[i].month, users.records[i].day);
+    }
+    if (bio_index_build(&index, birth_days, users.count, today) != 0) {
+        printf("Error: Out of memory.\n");
+        free(birth_days);
+        free(matches);
+        records_free(&users);
+        return 1;
+    }
+
+    for (int d = 0; d < num_days; d++) {
+        char date_str[11];
+        jd_format(index.today, date_str);
+        size_t found = bio_index_query(&index, &pred, matches, users.count);
+        printf("# %s: %zu of %zu users match %s\n", date_str, found, users.count, query);
+        for (size_t i = 0; i < found; i++) {
+            const struct UserRecord *rec = &users.records[matches[i]];
+            printf("%s\t%.*s\n", date_str, rec->id_len, rec->id);
+        }
+        bio_index_advance(&index, 1);
+    }
+
+    bio_index_free(&index);
+    free(birth_days);
+    free(matches);
+    records_free(&users);
+    return 0;
+}
+
+// Scores biorhythm compatibility within a group: one user against all others
+// when with_id is given, otherwise a histogram over all pairs
+int run_compatibility(const char *path, const char *with_id, int num_threads) {
+    struct RecordSet users;
+    if (load_user_records(path, &users, num_threads) != 0) {
+        return 1;
+    }
+
+    long *birth_days = malloc((users.count ? users.count : 1) * sizeof(*birth_days));
+    double *scores = malloc((users.count ? users.count : 1) * sizeof(*scores));
+    struct BioIndex index;
+    if (!birth_days || !scores) {
+        printf("Error: Out of memory.\n");
+        free(birth_days);
+        free(scores);
+        records_free(&users);
+        return 1;
+    }
+    for (size_t i = 0; i < users.count; i++) {
+        birth_days[i] = jd_from_civil(users.records[i].year, users.records[i].month, users.records[i].day);
+    }
+    int status = 0;
+    if (bio_index_build(&index, birth_days, users.count, 0) != 0) {
+        printf("Error: Out of memory.\n");
+        status = 1;
+    } else if (with_id) {
+        size_t self = users.count;
+        for (size_t i = 0; i < users.count && self == users.count; i++) {
+            const struct UserRecord *rec = &users.records[i];
+            if ((size_t)rec->id_len == strlen(with_id) && memcmp(rec->id, with_id, rec->id_len) == 0) self = i;
+        }
+        if (self == users.count) {
+            printf("Error: No user '%s' in %s.\n", with_id, path);
+            status = 1;
+        } else {
+            bio_index_compat_one(&index, birth_days[self], scores);
+            for (size_t i = 0; i < users.count; i++) {
+                if (i == self) continue;
+                printf("%.*s\t%+.0f%%\n", users.records[i].id_len, users.records[i].id, scores[i]);
+            }
+        }
+        bio_index_free(&index);
+    } else {
+        uint64_t hist[201];
+        if (bio_index_compat_pairs(&index, hist) != 0) {
+            printf("Error: Out of memory.\n");
+            status = 1;
+        } else {
+            printf("# Biorhythm compatibility over all pairs of %zu users (score, pairs)\n", users.count);
+            for (int score = -100; score <= 100; score++) {
+                if (hist[score + 100]) printf("%+d%%\t%llu\n", score, (unsigned long long)hist[score + 100]);
+            }
+        }
+        bio_index_free(&index);
+    }
+
+    free(birth_days);
+    free(scores);
+    records_free(&users);
+    return status;
+}
 
-        if (fabs(angle_diff - 120) <= ORB_TRINE_SQR_SEX || fabs(angle_diff - 60) <= ORB_TRINE_SQR_SEX) {
-            positive_aspects++;
+#define CHART_BLOCK_USERS 4096 // Users whose series are built before each write
+#define CHART_DATE_BLOCK  256  // Chart dates converted per pass
+
+// Prints a day-by-day biorhythm chart starting today
+void print_biorhythm_chart(const struct BiorhythmSample series[], int num_days) {
+    struct OutBuf out;
+    outbuf_init(&out);
+    long today = jd_today_utc();
+    long days[CHART_DATE_BLOCK];
+    int years[CHART_DATE_BLOCK], months[CHART_DATE_BLOCK], mdays[CHART_DATE_BLOCK];
+    for (int first = 0; first < num_days; first += CHART_DATE_BLOCK) {
+        int n = num_days - first < CHART_DATE_BLOCK ? num_days - first : CHART_DATE_BLOCK;
+        jd_range(today + first, n, days);
+        jd_to_civil_n(days, n, years, months, mdays);
+        for (int d = 0; d < n; d++) {
+            const struct BiorhythmSample *s = &series[first + d];
+            char date_str[11];
+            jd_format_civil(years[d], months[d], mdays[d], date_str);
+            outbuf_printf(&out, "\n%s\n", date_str);
+            print_biorhythm_line(&out, "Physical:     ", s->physical);
+            print_biorhythm_line(&out, "Emotional:    ", s->emotional);
+            print_biorhythm_line(&out, "Intellectual: ", s->intellectual);
         }
-        if (fabs(angle_diff - 180) <= ORB_CONJ_OPP || fabs(angle_diff - 90) <= ORB_TRINE_SQR_SEX) {
-            negative_aspects++;
+    }
+    outbuf_flush(&out, stdout);
+    outbuf_free(&out);
+}
+
+// Prints the biorhythm critical days, peaks and troughs for the next num_days days
+int print_biorhythm_calendar(int year, int month, int day, int num_days) {
+    static const char *cycle_names[] = {"Physical", "Emotional", "Intellectual"};
+    static const char *kind_names[] = {"critical day (rising)", "peak", "critical day (falling)", "trough"};
+
+    long birth_jdn = jd_from_civil(year, month, day);
+    long first_day = jd_today_utc() - birth_jdn;
+    long last_day = first_day + num_days - 1;
+    int capacity = biorhythm_calendar_capacity(first_day, last_day);
+    struct BiorhythmEvent *events = malloc(capacity * sizeof(*events));
+    if (!events) return -1;
+    int num_events = biorhythm_calendar(first_day, last_day, events, capacity);
+
+    printf("\n--- Biorhythm Calendar ---\n");
+    for (int i = 0; i < num_events; i++) {
+        char date_str[11];
+        jd_format(birth_jdn + events[i].day, date_str);
+
+        if (events[i].kind == BIO_EVENT_MULTI_CRITICAL) {
+            printf("%s  " COLOR_RED "Multiple critical days:" COLOR_RESET, date_str);
+            for (int c = 0; c < 3; c++) {
+                if (events[i].cycles & (1 << c)) printf(" %s", cycle_names[c]);
+            }
+            printf("\n");
+        } else {
+            int c = events[i].cycles == BIO_CYCLE_PHYSICAL ? 0 : events[i].cycles == BIO_CYCLE_EMOTIONAL ? 1 : 2;
+            printf("%s  %s %s\n", date_str, cycle_names[c], kind_names[events[i].kind]);
         }
-        if (strcmp(planets[i].name, "Sun") == 0) {
-            int planet_sign_idx = get_zodiac_index(planets[i].longitude);
-            int house_num = (planet_sign_idx - sun_sign_idx + 12) % 12;
-            focus_house = house_keywords[house_num];
+    }
+    printf("--------------------------\n");
+
+    free(events);
+    return 0;
+}
+
+// Writes a series as raw struct BiorhythmSample records. Returns 0 on success, -1 on failure.
+int write_biorhythm_series(const char *path, const struct BiorhythmSample series[], int num_days) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    size_t written = fwrite(series, sizeof(series[0]), num_days, f);
+    if (fclose(f) != 0 || written != (size_t)num_days) return -1;
+    return 0;
+}
+
+// Writes num_days of biorhythm samples for every user in a record file, user
+// after user, in the raw format of write_biorhythm_series(). Users without a
+// birth time go through the phase tables; the others take the exact rotation path.
+int run_chart_users(const char *path, int num_days, const char *output_path, int num_threads) {
+    struct RecordSet users;
+    if (load_user_records(path, &users, num_threads) != 0) {
+        return 1;
+    }
+    long *first_days = malloc(CHART_BLOCK_USERS * sizeof(*first_days));
+    struct BiorhythmSample *block = malloc((size_t)CHART_BLOCK_USERS * num_days * sizeof(*block));
+    FILE *f = first_days && block ? fopen(output_path, "wb") : NULL;
+    if (!f) {
+        if (first_days && block) printf("Error: Could not write %s.\n", output_path);
+        else printf("Error: Out of memory.\n");
+        free(first_days);
+        free(block);
+        records_free(&users);
+        return 1;
+    }
+
+    double day_fraction;
+    long today = jd_now_utc(&day_fraction);
+    double now = today - 0.5 + day_fraction;
+    int failed = 0;
+    for (size_t first = 0; first < users.count && !failed; first += CHART_BLOCK_USERS) {
+        int n = users.count - first < CHART_BLOCK_USERS ? (int)(users.count - first) : CHART_BLOCK_USERS;
+        const struct UserRecord *recs = users.records + first;
+        for (int u = 0; u < n; u++) first_days[u] = today - jd_from_civil(recs[u].year, recs[u].month, recs[u].day);
+        biorhythm_series_batch(first_days, n, num_days, block);
+        for (int u = 0; u < n; u++) {
+            if (recs[u].birth_minute < 0) continue;
+            double birth_jd = jd_from_civil(recs[u].year, recs[u].month, recs[u].day) - 0.5
+                            + recs[u].birth_minute / (24.0 * 60.0);
+            biorhythm_series_exact(now - birth_jd, num_days, block + (size_t)u * num_days);
         }
+        failed = fwrite(block, sizeof(*block), (size_t)n * num_days, f) != (size_t)n * num_days;
+    }
+    failed |= fclose(f) != 0;
+    if (failed) {
+        printf("Error: Could not write %s.\n", output_path);
+    } else {
+        fprintf(stderr, "Chart: %d days for %zu users written to %s.\n", num_days, users.count, output_path);
+    }
+    free(first_days);
+    free(block);
+    records_free(&users);
+    return failed ? 1 : 0;
+}
+
+// Prompts for a birth date on stdin. Returns 0 on success, -1 on invalid input.
+int read_birth_date(int *year, int *month, int *day) {
+    printf("Please enter your birth date.\n");
+    printf("Year (e.g., 1990): ");
+    if (scanf("%d", year) != 1) return -1;
+    printf("Month (1-12): ");
+    if (scanf("%d", month) != 1) return -1;
+    printf("Day (1-31): ");
+    if (scanf("%d", day) != 1) return -1;
+
+    if (*year < 1900 || !jd_valid_civil(*year, *month, *day) || jd_from_civil(*year, *month, *day) > jd_today_utc()) {
+        return -1;
+    }
+    return 0;
+}
+
+void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --chart=N          Print a biorhythm chart for the next N days (no NASA data needed)\n");
+    printf("  --chart-out=FILE   With --chart, also write the series as raw int8 triples to FILE\n");
+    printf("  --chart-users=FILE With --chart and --chart-out, write the series of every user in FILE instead\n");
+    printf("  --calendar=N       Print biorhythm critical days, peaks and troughs for the next N days\n");
+    printf("  --population=FILE  Answer --query for every user in FILE (id,YYYY-MM-DD per line; - for stdin)\n");
+    printf("  --query=EXPR       triple-high|triple-low|triple-critical or CYCLE:LEVEL[,...], e.g. physical:high\n");
+    printf("  --query-days=N     Repeat the population query for N days starting today (default 1)\n");
+    printf("  --compat=FILE      Biorhythm compatibility histogram over all pairs of users in FILE\n");
+    printf("  --compat-with=ID   With --compat, score user ID against everyone else instead\n");
+    printf("  --batch=FILE       Forecast every user in FILE (id,YYYY-MM-DD[,HH:MM] per line; - for stdin)\n");
+    printf("  --from=DATE        Forecast every day from DATE (YYYY-MM-DD) instead of just today\n");
+    printf("  --to=DATE          Last day of the --from range (default: the --from date)\n");
+    printf("  --signs=FILE       Sun sign histogram of every user in FILE from a precomputed ingress table\n");
+    printf("  --labels           With --signs, print each user's sign instead of the histogram\n");
+    printf("  --format=FMT       Output format for --batch and --from: text (default), json or ndjson\n");
+    printf("  --output=FILE      With --batch, --from or --signs --labels, write reports to FILE instead of stdout\n");
+    printf("  --export=FILE      With --batch, write positions, houses, aspects and biorhythms as columnar data\n");
+    printf("                     Output and export files ending in .gz are gzip-compressed on a separate thread\n");
+    printf("  --serve=PORT       Serve GET /forecast?birth=YYYY-MM-DD[&time=HH:MM][&format=json|text] over HTTP\n");
+    printf("                     on 127.0.0.1:PORT (or ADDR:PORT) from a daily snapshot refreshed in the background\n");
+    printf("  --no-cache         Fetch positions from NASA instead of sharing them with other processes\n");
+    printf("  --threads=N        Worker threads for --batch, --serve and reading user files (default: number of CPUs)\n");
+    printf("  --templates=FILE   Override report wording from a template pack (key = text per line)\n");
+    printf("  --bench=N          Time N synthetic reports through the old and new output paths\n");
+    printf("  -h, --help         Show this help\n");
+}
+
+// Renders the detailed forecast with a template set
+static void render_forecast(struct OutBuf *out, const struct ReportTemplates *t, const struct Planet planets[],
+                            const struct Forecast *f) {
+    struct TemplateArgs args = { .sign = sun_sign_names[f->sun_sign] };
+    template_render(out, t->forecast_header, &args);
+    
+    // --- House Transits Section ---
+    template_render(out, t->transits, &args);
+    for (int i = 0; i < f->num_bodies; i++) {
+        args.planet = planets[i].name;
+        args.keyword = planets[i].keyword;
+        args.house = f->house[i];
+        args.house_keyword = t->house_keyword[f->house[i] - 1];
+        template_render(out, t->transit, &args);
+    }
+
+    // --- Major Aspects Section ---
+    template_render(out, t->aspects, &args);
+    for (int a = 0; a < f->num_aspects; a++) {
+        const struct Planet *planet = &planets[f->aspects[a].body];
+        args.planet = planet->name;
+        args.keyword = planet->keyword;
+        template_render(out, t->aspect[f->aspects[a].aspect], &args);
+    }
+
+    if (f->num_aspects == 0) {
+        template_render(out, t->no_aspects, &args);
     }
+    template_render(out, t->forecast_footer, &args);
+}
+
+// Renders the detailed forecast for the terminal
+void generate_forecast(struct OutBuf *out, const struct Planet planets[], const struct Forecast *f) {
+    render_forecast(out, &tpl, planets, f);
+}
 
-    // --- Biorhythm Calculation ---
-    struct tm birth_tm = {0};
-    birth_tm.tm_year = year - 1900;
-    birth_tm.tm_mon = month - 1;
-    birth_tm.tm_mday = day;
-    time_t birth_t = mktime(&birth_tm);
-    time_t now_t = time(NULL);
-    double days_alive = difftime(now_t, birth_t) / (60 * 60 * 24);
-    double physical = sin(2 * M_PI * days_alive / 23) * 100;
-    double emotional = sin(2 * M_PI * days_alive / 28) * 100;
-    double intellectual = sin(2 * M_PI * days_alive / 33) * 100;
+// The forecast section depends only on the Sun sign and the day's positions,
+// so a day has exactly twelve distinct ones. The memo computes and renders each once.
+struct ForecastMemo {
+    long jdn; // Ephemeris day the entries were made for; 0 while empty
+    const struct ReportTemplates *templates;
+    struct Forecast sky[12]; // Sky part only; biorhythms are per user
+    struct OutBuf text[12];
+};
+
+// Starts an empty memo whose text is rendered with templates.
+void forecast_memo_init(struct ForecastMemo *memo, const struct ReportTemplates *templates) {
+    memo->jdn = 0;
+    memo->templates = templates;
+    for (int s = 0; s < 12; s++) outbuf_init(&memo->text[s]);
+}
+
+void forecast_memo_free(struct ForecastMemo *memo) {
+    for (int s = 0; s < 12; s++) outbuf_free(&memo->text[s]);
+    memo->jdn = 0;
+}
+
+// Recomputes all twelve entries when the positions belong to a different day
+// than the cached ones. Must not run while other threads read the memo.
+void forecast_memo_update(struct ForecastMemo *memo, const struct Planet planets[], const struct PlanetSlice *day,
+                          int sun_body, long jdn) {
+    if (memo->jdn == jdn) return;
+    for (int s = 0; s < 12; s++) {
+        forecast_compute_sky(&memo->sky[s], day, s, sun_body);
+        memo->text[s].len = 0;
+        render_forecast(&memo->text[s], memo->templates, planets, &memo->sky[s]);
+    }
+    memo->jdn = jdn;
+}
+
+// Renders a single, combined summary report with a template set
+static void render_final_report(struct OutBuf *out, const struct ReportTemplates *t, const struct Forecast *f) {
+    struct TemplateArgs args = { .sign = sun_sign_names[f->sun_sign] };
+    double physical = f->bio.physical;
+    double emotional = f->bio.emotional;
+    double intellectual = f->bio.intellectual;
 
     // --- Final Report Generation ---
-    printf("\n--- Your Personal Forecast ---\n");
+    template_render(out, t->report_header, &args);
     
     // Biorhythm Chart
-    printf("\nBiorhythms:\n");
-    printf("Physical:     %4.0f%% ", physical);
-    print_biorhythm_bar(physical);
-    printf("\n");
-    printf("Emotional:    %4.0f%% ", emotional);
-    print_biorhythm_bar(emotional);
-    printf("\n");
-    printf("Intellectual: %4.0f%% ", intellectual);
-    print_biorhythm_bar(intellectual);
-    printf("\n\n");
+    print_biorhythm_line(out, "Physical:     ", physical);
+    print_biorhythm_line(out, "Emotional:    ", emotional);
+    print_biorhythm_line(out, "Intellectual: ", intellectual);
 
     // Astrological Summary
-    printf("Summary: ");
-    if (positive_aspects > negative_aspects) {
-        printf("Astrologically, today looks to be a positive day, with opportunities for growth and harmony. ");
-    } else if (negative_aspects > positive_aspects) {
-        printf("Astrologically, you may face some challenges today, requiring patience and careful thought. ");
-    } else {
-        printf("Astrologically, today brings a mix of opportunities and challenges, requiring balance. ");
-    }
-    if(focus_house) {
-        printf("The main focus is on the area of %s. ", focus_house);
+    template_render(out, t->summary, &args);
+    template_render(out, t->outlook[forecast_outlook(f)], &args);
+    if (f->focus_house) {
+        args.house = f->focus_house;
+        args.house_keyword = t->house_keyword[f->focus_house - 1];
+        template_render(out, t->focus, &args);
     }
     
     // Biorhythm Summary
-    printf("\nFrom a biorhythm perspective: ");
-    if (physical > 50) {
-        printf(COLOR_GREEN "Physically, you should be feeling strong and energetic. " COLOR_RESET);
-    } else if (physical < -50) {
-        printf(COLOR_RED "Physically, you may feel low on energy. " COLOR_RESET);
+    template_render(out, t->biorhythm, &args);
+    template_render(out, t->physical[physical > 50 ? BIO_HIGH : physical < -50 ? BIO_LOW : BIO_NORMAL], &args);
+    template_render(out, t->emotional[emotional > 50 ? BIO_HIGH : emotional < -50 ? BIO_LOW : BIO_NORMAL], &args);
+    template_render(out, t->intellectual[intellectual > 50 ? BIO_HIGH : intellectual < -50 ? BIO_LOW : BIO_NORMAL], &args);
+    
+    template_render(out, t->report_footer, &args);
+}
+
+// Renders the summary report for the terminal
+void generate_final_report(struct OutBuf *out, const struct Forecast *f) {
+    render_final_report(out, &tpl, f);
+}
+
+// Renders a forecast as one JSON object with the same content as the two text sections
+void generate_forecast_json(struct JsonWriter *w, const struct Planet planets[], const struct Forecast *f) {
+    jsonw_key(w, "sign");
+    jsonw_string(w, sun_sign_names[f->sun_sign]);
+
+    jsonw_key(w, "houses");
+    jsonw_begin_array(w);
+    for (int i = 0; i < f->num_bodies; i++) {
+        jsonw_begin_object(w);
+        jsonw_key(w, "body");
+        jsonw_string(w, planets[i].name);
+        jsonw_key(w, "house");
+        jsonw_int(w, f->house[i]);
+        jsonw_end_object(w);
+    }
+    jsonw_end_array(w);
+
+    jsonw_key(w, "aspects");
+    jsonw_begin_array(w);
+    for (int a = 0; a < f->num_aspects; a++) {
+        jsonw_begin_object(w);
+        jsonw_key(w, "body");
+        jsonw_string(w, planets[f->aspects[a].body].name);
+        jsonw_key(w, "aspect");
+        jsonw_string(w, aspect_names[f->aspects[a].aspect]);
+        jsonw_key(w, "orb");
+        jsonw_fixed(w, f->aspects[a].orb, 2);
+        jsonw_end_object(w);
+    }
+    jsonw_end_array(w);
+
+    jsonw_key(w, "positive_aspects");
+    jsonw_int(w, f->positive_aspects);
+    jsonw_key(w, "negative_aspects");
+    jsonw_int(w, f->negative_aspects);
+    jsonw_key(w, "focus_house");
+    if (f->focus_house) jsonw_int(w, f->focus_house);
+    else jsonw_null(w);
+
+    jsonw_key(w, "biorhythm");
+    jsonw_begin_object(w);
+    jsonw_key(w, "physical");
+    jsonw_fixed(w, f->bio.physical, 1);
+    jsonw_key(w, "emotional");
+    jsonw_fixed(w, f->bio.emotional, 1);
+    jsonw_key(w, "intellectual");
+    jsonw_fixed(w, f->bio.intellectual, 1);
+    jsonw_end_object(w);
+
+    jsonw_key(w, "summary");
+    jsonw_string(w, outlook_names[forecast_outlook(f)]);
+}
+
+// Cleared by --no-cache, so every process fetches its own positions.
+static int use_shared_cache = 1;
+
+// Fills positions from the shared cache when enabled, else straight from
+// Horizons. Returns the number of bodies fetched; *cached is set when the
+// positions came from another process.
+static int fetch_positions(CURL *curl, const char *const body_ids[], long first_jdn, struct PlanetSeries *ps,
+                           int *cached) {
+    *cached = 0;
+    if (use_shared_cache) return shmcache_fetch_series(curl, body_ids, first_jdn, ps, cached);
+    return horizons_fetch_series(curl, body_ids, first_jdn, ps);
+}
+
+static int compare_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+#define BATCH_CHUNK_RECORDS 64   // Records per unit of parallel work
+#define BATCH_RING_RECORDS  4096 // Rendered records that may wait for the writer, at least
+
+// Shared, read-only inputs of a batch run plus its per-thread scratch and output stage.
+struct BatchJob {
+    const struct Planet *planets;
+    const struct RecordSet *users;
+    enum OutputFormat format;
+    long today_jdn;
+    double day_fraction; // Time of day shared by every record's exact biorhythm
+    const long *unique_birth_days;
+    const int *unique_signs;
+    size_t num_unique;
+    const struct ForecastMemo *forecasts;
+    struct OutBuf *worker_out; // One scratch buffer per thread
+    struct OrderedWriter *writer;
+};
+
+// Renders one record as a JSON object; seq > 0 is preceded by the array separator in --format=json.
+static void render_batch_record_json(struct OutBuf *out, const struct BatchJob *job, const struct UserRecord *rec,
+                                     size_t seq, int sun_sign_idx) {
+    if (job->format == FORMAT_JSON && seq > 0) outbuf_write(out, ",\n", 2);
+
+    char date_str[11];
+    struct JsonWriter w;
+    jsonw_init(&w, out);
+    jsonw_begin_object(&w);
+    jsonw_key(&w, "id");
+    jsonw_string_n(&w, rec->id, rec->id_len);
+    jsonw_key(&w, "birth_date");
+    jd_format(jd_from_civil(rec->year, rec->month, rec->day), date_str);
+    jsonw_string(&w, date_str);
+    jsonw_key(&w, "date");
+    jd_format(job->today_jdn, date_str);
+    jsonw_string(&w, date_str);
+    if (sun_sign_idx < 0) {
+        jsonw_key(&w, "error");
+        jsonw_string(&w, "sun sign unavailable");
+    } else {
+        struct Forecast f = job->forecasts->sky[sun_sign_idx];
+        forecast_compute_biorhythm_on(&f, rec->year, rec->month, rec->day, rec->birth_minute, job->today_jdn,
+                                      job->day_fraction);
+        generate_forecast_json(&w, job->planets, &f);
+    }
+    jsonw_end_object(&w);
+    if (job->format == FORMAT_NDJSON) outbuf_putc(out, '\n');
+}
+
+// Sun sign of a record from the per-birth-date lookups, or -1 if it could not be fetched.
+static int batch_record_sign(const struct BatchJob *job, const struct UserRecord *rec) {
+    long birth_jdn = jd_from_civil(rec->year, rec->month, rec->day);
+    const long *found = bsearch(&birth_jdn, job->unique_birth_days, job->num_unique, sizeof(long), compare_long);
+    return job->unique_signs[found - job->unique_birth_days];
+}
+
+// Renders one record's forecast. Safe to call from several threads at once.
+static void render_batch_record(struct OutBuf *out, const struct BatchJob *job, const struct UserRecord *rec, size_t seq) {
+    int sun_sign_idx = batch_record_sign(job, rec);
+
+    if (job->format != FORMAT_TEXT) {
+        render_batch_record_json(out, job, rec, seq, sun_sign_idx);
+        return;
+    }
+
+    outbuf_printf(out, "\n=== %.*s (%04d-%02d-%02d) ===\n", rec->id_len, rec->id, rec->year, rec->month, rec->day);
+    if (sun_sign_idx < 0) {
+        outbuf_puts(out, "Error: Could not calculate Sun Sign. The NASA API might be temporarily unavailable or the date is invalid.\n");
+        return;
+    }
+    outbuf_printf(out, "Your true Sun sign is %s.\n", sun_sign_names[sun_sign_idx]);
+    const struct OutBuf *forecast = &job->forecasts->text[sun_sign_idx];
+    outbuf_write(out, forecast->data, forecast->len);
+
+    struct Forecast f = job->forecasts->sky[sun_sign_idx];
+    forecast_compute_biorhythm_on(&f, rec->year, rec->month, rec->day, rec->birth_minute, job->today_jdn,
+                                  job->day_fraction);
+    generate_final_report(out, &f);
+}
+
+static void run_batch_chunk(void *ctx, size_t chunk, int worker) {
+    struct BatchJob *job = ctx;
+    struct OutBuf *out = &job->worker_out[worker];
+    size_t first = chunk * BATCH_CHUNK_RECORDS;
+    size_t last = first + BATCH_CHUNK_RECORDS < job->users->count ? first + BATCH_CHUNK_RECORDS : job->users->count;
+
+    // Record i is sequence number i, so the writer emits them in input order.
+    for (size_t i = first; i < last; i++) {
+        render_batch_record(out, job, &job->users->records[i], i);
+        ordered_writer_commit(job->writer, i, out);
+    }
+}
+
+// --- Output Files ---
+// Destination of --output and --export data: stdout, a file, or a gzip file
+// compressed on its own thread when the name ends in ".gz".
+struct OutputFile {
+    const char *path; // NULL for stdout
+    int fd;
+    struct GzStream *gz;
+};
+
+int output_open(struct OutputFile *o, const char *path) {
+    o->path = path;
+    o->gz = NULL;
+    o->fd = path ? open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (o->fd < 0) {
+        printf("Error: Could not create %s.\n", path);
+        return -1;
+    }
+    if (path && gz_path(path)) {
+        o->gz = gz_stream_open(o->fd, GZ_DEFAULT_LEVEL);
+        if (!o->gz) {
+            printf("Error: Could not start compressing %s.\n", path);
+            close(o->fd);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Ordered-writer sink: hands each buffer to the compressor, or writev()s them.
+int output_sink(void *ctx, struct iovec *iov, int count) {
+    struct OutputFile *o = ctx;
+    if (!o->gz) return ordered_fd_sink(&o->fd, iov, count);
+    for (int i = 0; i < count; i++) {
+        if (gz_stream_write(o->gz, iov[i].iov_base, iov[i].iov_len) != 0) return -1;
+    }
+    return 0;
+}
+
+int output_write(struct OutputFile *o, const void *data, size_t n) {
+    struct iovec iov = { (void *)data, n };
+    return output_sink(o, &iov, 1);
+}
+
+static ssize_t output_cookie_write(void *ctx, const char *buf, size_t n) {
+    return output_write(ctx, buf, n) == 0 ? (ssize_t)n : -1;
+}
+
+// A stdio stream over the output, for writers that take a FILE.
+FILE *output_stream(struct OutputFile *o) {
+    cookie_io_functions_t io = { .write = output_cookie_write };
+    return fopencookie(o, "w", io);
+}
+
+// Finishes compression and closes the file, reporting throughput for .gz outputs.
+int output_close(struct OutputFile *o) {
+    int status = 0;
+    if (o->gz) {
+        struct GzStats stats;
+        status = gz_stream_close(o->gz, &stats);
+        double mb_in = stats.bytes_in / 1e6, mb_out = stats.bytes_out / 1e6;
+        fprintf(stderr, "Compressed %.1f MB to %.1f MB (%.1f%%): %.1f MB/s compressor, %.1f MB/s overall.\n",
+                mb_in, mb_out, mb_in > 0 ? 100.0 * mb_out / mb_in : 0.0,
+                stats.busy_seconds > 0 ? mb_in / stats.busy_seconds : 0.0,
+                stats.wall_seconds > 0 ? mb_in / stats.wall_seconds : 0.0);
+    }
+    if (o->path && close(o->fd) != 0) status = -1;
+    return status;
+}
+
+// Renders every record on the thread pool and streams the reports to the output in input order.
+static int render_batch(struct BatchJob *job, int num_threads, const char *output_path) {
+    struct OutputFile output;
+    // The writer bypasses stdio, so anything already buffered must go first.
+    fflush(stdout);
+    if (output_open(&output, output_path) != 0) return 1;
+    if (job->format == FORMAT_JSON) output_write(&output, "[\n", 2);
+    size_t num_chunks = (job->users->count + BATCH_CHUNK_RECORDS - 1) / BATCH_CHUNK_RECORDS;
+    job->worker_out = calloc(num_threads, sizeof(struct OutBuf));
+    // Chunks start in order, so the ring need only span the ones in flight, with
+    // a second lap of slack for threads that run ahead of a slow chunk.
+    size_t ring = 2 * (size_t)num_threads * BATCH_CHUNK_RECORDS;
+    job->writer = ordered_writer_start(output_sink, &output, job->users->count,
+                                       ring > BATCH_RING_RECORDS ? ring : BATCH_RING_RECORDS);
+    int status = 0;
+    if (!job->worker_out || !job->writer) {
+        printf("Error: Out of memory.\n");
+        status = 1;
+    } else {
+        pool_run_ordered(num_threads, num_chunks, run_batch_chunk, job);
+    }
+    int failed = job->writer && ordered_writer_finish(job->writer) != 0;
+    if (job->format == FORMAT_JSON) failed |= output_write(&output, "\n]\n", 3) != 0;
+    failed |= output_close(&output) != 0;
+    if (failed) {
+        fprintf(stderr, "Error: Could not write forecasts.\n");
+        status = 1;
+    }
+    if (job->worker_out) {
+        for (int t = 0; t < num_threads; t++) outbuf_free(&job->worker_out[t]);
+    }
+    free(job->worker_out);
+    return status;
+}
+
+// --- Columnar Export ---
+#define EXPORT_BATCH_ROWS 65536 // Rows per record batch; bounds memory per table
+
+enum { DICT_SIGN, DICT_BODY, DICT_HOUSE, DICT_ASPECT, DICT_OUTLOOK };
+
+static const struct ColumnSpec position_columns[] = {
+    {"date", COL_I32, -1}, {"body", COL_U8, DICT_BODY}, {"longitude", COL_F32, -1},
+    {"latitude", COL_F32, -1}, {"speed", COL_F32, -1}, {"sign", COL_U8, DICT_SIGN}
+};
+static const struct ColumnSpec user_columns[] = {
+    {"user", COL_U32, -1}, {"birth_date", COL_I32, -1}, {"sign", COL_U8, DICT_SIGN},
+    {"focus_house", COL_U8, DICT_HOUSE}, {"physical", COL_F32, -1}, {"emotional", COL_F32, -1},
+    {"intellectual", COL_F32, -1}, {"outlook", COL_U8, DICT_OUTLOOK}
+};
+static const struct ColumnSpec transit_columns[] = {
+    {"user", COL_U32, -1}, {"body", COL_U8, DICT_BODY}, {"house", COL_U8, DICT_HOUSE}
+};
+static const struct ColumnSpec aspect_columns[] = {
+    {"user", COL_U32, -1}, {"body", COL_U8, DICT_BODY}, {"aspect", COL_U8, DICT_ASPECT}, {"orb", COL_F32, -1}
+};
+
+#define NUM_COLUMNS(cols) ((int)(sizeof(cols) / sizeof(cols[0])))
+
+// Writes the day's positions and every user's forecast as columnar tables
+// (see colexport.h). Dates are Julian Day Numbers; users are numbered in
+// input order and the user column of the other tables refers to that number.
+static int export_columns(const char *path, const struct BatchJob *job, const struct PlanetSlice *today) {
+    static const char *const house_names[] = {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12"};
+    struct OutputFile output;
+    if (output_open(&output, path) != 0) return 1;
+    FILE *stream = output_stream(&output);
+    struct ColumnFile cf;
+    if (!stream || colfile_open(&cf, stream) != 0) {
+        printf("Error: Could not write %s.\n", path);
+        if (stream) fclose(stream);
+        output_close(&output);
+        return 1;
+    }
+
+    const char *body_names[FORECAST_MAX_BODIES];
+    int num_bodies = today->num_bodies < FORECAST_MAX_BODIES ? today->num_bodies : FORECAST_MAX_BODIES;
+    for (int b = 0; b < num_bodies; b++) body_names[b] = job->planets[b].name;
+    colfile_dictionary(&cf, DICT_SIGN, sun_sign_names, 12);
+    colfile_dictionary(&cf, DICT_BODY, body_names, num_bodies);
+    colfile_dictionary(&cf, DICT_HOUSE, house_names, 12);
+    colfile_dictionary(&cf, DICT_ASPECT, aspect_names, ASPECT_SEXTILE + 1);
+    colfile_dictionary(&cf, DICT_OUTLOOK, outlook_names, OUTLOOK_CHALLENGING + 1);
+
+    // Every table is declared up front; their batches then interleave in the stream.
+    struct ColumnTable positions, users, transits, aspects;
+    int ok = coltable_init(&positions, &cf, "positions", position_columns, NUM_COLUMNS(position_columns), num_bodies) == 0;
+    ok &= coltable_init(&users, &cf, "users", user_columns, NUM_COLUMNS(user_columns), EXPORT_BATCH_ROWS) == 0;
+    ok &= coltable_init(&transits, &cf, "transits", transit_columns, NUM_COLUMNS(transit_columns), EXPORT_BATCH_ROWS) == 0;
+    ok &= coltable_init(&aspects, &cf, "aspects", aspect_columns, NUM_COLUMNS(aspect_columns), EXPORT_BATCH_ROWS) == 0;
+
+    if (ok) {
+        for (int b = 0; b < num_bodies; b++) {
+            coltable_i32(&positions, 0, (int32_t)job->today_jdn);
+            coltable_u8(&positions, 1, (uint8_t)b);
+            coltable_f32(&positions, 2, (float)bam_to_deg(slice_longitude(today, b)));
+            coltable_f32(&positions, 3, today->latitude[b * today->stride]);
+            coltable_f32(&positions, 4, today->speed[b * today->stride]);
+            coltable_u8(&positions, 5, (uint8_t)slice_sign(today, b));
+            coltable_end_row(&positions);
+        }
+
+        for (size_t i = 0; i < job->users->count; i++) {
+            const struct UserRecord *rec = &job->users->records[i];
+            int sun_sign_idx = batch_record_sign(job, rec);
+            struct Forecast f;
+            if (sun_sign_idx >= 0) f = job->forecasts->sky[sun_sign_idx];
+            forecast_compute_biorhythm_on(&f, rec->year, rec->month, rec->day, rec->birth_minute, job->today_jdn,
+                                          job->day_fraction);
+
+            coltable_u32(&users, 0, (uint32_t)i);
+            coltable_i32(&users, 1, (int32_t)jd_from_civil(rec->year, rec->month, rec->day));
+            coltable_u8(&users, 2, sun_sign_idx >= 0 ? (uint8_t)sun_sign_idx : COL_NULL_U8);
+            coltable_u8(&users, 3, sun_sign_idx >= 0 && f.focus_house ? (uint8_t)(f.focus_house - 1) : COL_NULL_U8);
+            coltable_f32(&users, 4, (float)f.bio.physical);
+            coltable_f32(&users, 5, (float)f.bio.emotional);
+            coltable_f32(&users, 6, (float)f.bio.intellectual);
+            coltable_u8(&users, 7, sun_sign_idx >= 0 ? (uint8_t)forecast_outlook(&f) : COL_NULL_U8);
+            coltable_end_row(&users);
+            if (sun_sign_idx < 0) continue;
+
+            for (int b = 0; b < f.num_bodies; b++) {
+                coltable_u32(&transits, 0, (uint32_t)i);
+                coltable_u8(&transits, 1, (uint8_t)b);
+                coltable_u8(&transits, 2, (uint8_t)(f.house[b] - 1));
+                coltable_end_row(&transits);
+            }
+            for (int a = 0; a < f.num_aspects; a++) {
+                coltable_u32(&aspects, 0, (uint32_t)i);
+                coltable_u8(&aspects, 1, (uint8_t)f.aspects[a].body);
+                coltable_u8(&aspects, 2, (uint8_t)f.aspects[a].aspect);
+                coltable_f32(&aspects, 3, f.aspects[a].orb);
+                coltable_end_row(&aspects);
+            }
+        }
+    }
+
+    coltable_finish(&positions);
+    coltable_finish(&users);
+    coltable_finish(&transits);
+    coltable_finish(&aspects);
+    int failed = colfile_close(&cf) != 0 || !ok;
+    failed |= fclose(stream) != 0;
+    failed |= output_close(&output) != 0;
+    if (failed) {
+        printf("Error: Could not write %s.\n", path);
+        return 1;
+    }
+    fprintf(stderr, "Export: %zu users written to %s.\n", job->users->count, path);
+    return 0;
+}
+
+// Produces forecasts for every record in a file. Today's positions are fetched
+// once and each distinct birth date's Sun sign is looked up once, however many
+// users share it. Forecasts stream to stdout; progress goes to stderr.
+int run_batch(const char *path, const struct Planet planets[], const char *const body_ids[], int num_planets,
+              int num_threads, enum OutputFormat format, const char *output_path, const char *export_path) {
+    struct RecordSet users;
+    if (load_user_records(path, &users, num_threads) != 0) {
+        return 1;
+    }
+
+    curl_global_init(CURL_GLOBAL_ALL);
+    CURL *curl_handle = curl_easy_init();
+    struct PlanetSeries positions;
+    long *birth_days = malloc((users.count ? users.count : 1) * sizeof(*birth_days));
+    int *unique_signs = malloc((users.count ? users.count : 1) * sizeof(*unique_signs));
+    if (!curl_handle || !birth_days || !unique_signs || planet_series_init(&positions, num_planets, 2) != 0) {
+        printf("Error: Out of memory.\n");
+        if (curl_handle) curl_easy_cleanup(curl_handle);
+        curl_global_cleanup();
+        free(birth_days);
+        free(unique_signs);
+        records_free(&users);
+        return 1;
+    }
+
+    // --- Shared Daily Positions ---
+    double day_fraction;
+    long today_jdn = jd_now_utc(&day_fraction);
+    int cached;
+    int fetched = fetch_positions(curl_handle, body_ids, today_jdn, &positions, &cached);
+    if (fetched < num_planets) {
+        // A body that failed to fetch sits at longitude 0 (Aries), which would
+        // put wrong houses and aspects into every forecast.
+        printf("Error: Only %d of %d bodies were fetched; not writing forecasts from incomplete positions.\n",
+               fetched, num_planets);
+        curl_easy_cleanup(curl_handle);
+        curl_global_cleanup();
+        planet_series_free(&positions);
+        free(birth_days);
+        free(unique_signs);
+        records_free(&users);
+        return 1;
+    }
+    struct PlanetSlice today = planet_series_day(&positions, 0);
+    struct ForecastMemo forecasts;
+    forecast_memo_init(&forecasts, &tpl);
+    forecast_memo_update(&forecasts, planets, &today, find_body(planets, num_planets, "Sun"), today_jdn);
+
+    // --- One Sun Sign Lookup per Distinct Birth Date ---
+    for (size_t i = 0; i < users.count; i++) {
+        birth_days[i] = jd_from_civil(users.records[i].year, users.records[i].month, users.records[i].day);
+    }
+    qsort(birth_days, users.count, sizeof(*birth_days), compare_long);
+    size_t num_unique = 0;
+    for (size_t i = 0; i < users.count; i++) {
+        if (num_unique == 0 || birth_days[i] != birth_days[num_unique - 1]) birth_days[num_unique++] = birth_days[i];
+    }
+    for (size_t u = 0; u < num_unique; u++) {
+        bam32_t sun_longitude;
+        unique_signs[u] = horizons_sun_longitude(curl_handle, birth_days[u], &sun_longitude) == 0
+                        ? get_zodiac_index(sun_longitude) : -1;
+    }
+    curl_easy_cleanup(curl_handle);
+    fprintf(stderr, "Batch: %zu records (%zu skipped), %zu distinct birth dates, %zu Horizons requests (%d of %d bodies fetched).\n",
+            users.count, users.skipped, num_unique, (cached ? 0 : num_planets) + num_unique, fetched, num_planets);
+
+    struct BatchJob job = {
+        .planets = planets, .users = &users, .format = format, .today_jdn = today_jdn, .day_fraction = day_fraction,
+        .unique_birth_days = birth_days, .unique_signs = unique_signs, .num_unique = num_unique,
+        .forecasts = &forecasts
+    };
+    int status = export_path ? export_columns(export_path, &job, &today) : render_batch(&job, num_threads, output_path);
+
+    forecast_memo_free(&forecasts);
+    planet_series_free(&positions);
+    curl_global_cleanup();
+    free(birth_days);
+    free(unique_signs);
+    records_free(&users);
+    return status;
+}
+
+// --- Sun Sign Analytics ---
+#define SIGNS_CHUNK_RECORDS 65536 // Records per unit of parallel work
+#define SIGNS_RING_CHUNKS   64    // Rendered label chunks that may wait for the writer, at least
+
+struct SignsJob {
+    const struct RecordSet *users;
+    uint64_t (*counts)[13];    // One histogram per thread
+    int8_t *signs;             // One chunk of labels per thread
+    struct OutBuf *worker_out; // With labels: one scratch buffer per thread
+    struct OrderedWriter *writer;
+};
+
+static void run_signs_chunk(void *ctx, size_t chunk, int worker) {
+    struct SignsJob *job = ctx;
+    size_t first = chunk * SIGNS_CHUNK_RECORDS;
+    size_t n = job->users->count - first < SIGNS_CHUNK_RECORDS ? job->users->count - first : SIGNS_CHUNK_RECORDS;
+    const struct UserRecord *records = job->users->records + first;
+    if (!job->writer) {
+        ingress_count_records(records, n, job->counts[worker]);
+        return;
+    }
+
+    int8_t *signs = job->signs + (size_t)worker * SIGNS_CHUNK_RECORDS;
+    struct OutBuf *out = &job->worker_out[worker];
+    ingress_sign_records(records, n, signs);
+    for (size_t i = 0; i < n; i++) {
+        outbuf_write(out, records[i].id, records[i].id_len);
+        outbuf_putc(out, '\t');
+        outbuf_puts(out, signs[i] < 0 ? "-" : sun_sign_names[signs[i]]);
+        outbuf_putc(out, '\n');
+    }
+    ordered_writer_commit(job->writer, chunk, out);
+}
+
+// Classifies every birth date in a record file by Sun sign from the ingress
+// table, printing a histogram or, with labels, one "id<TAB>sign" line per user.
+int run_signs(const char *path, int labels, int num_threads, const char *output_path) {
+    struct RecordSet users;
+    if (load_user_records(path, &users, num_threads) != 0) {
+        return 1;
+    }
+    ingress_init();
+
+    struct SignsJob job = { .users = &users };
+    struct OutputFile output;
+    size_t num_chunks = (users.count + SIGNS_CHUNK_RECORDS - 1) / SIGNS_CHUNK_RECORDS;
+    job.counts = calloc(num_threads, sizeof(*job.counts));
+    if (labels) {
+        fflush(stdout);
+        if (output_open(&output, output_path) != 0) {
+            free(job.counts);
+            records_free(&users);
+            return 1;
+        }
+        job.signs = malloc((size_t)num_threads * SIGNS_CHUNK_RECORDS);
+        job.worker_out = calloc(num_threads, sizeof(struct OutBuf));
+        size_t ring = 2 * (size_t)num_threads;
+        job.writer = ordered_writer_start(output_sink, &output, num_chunks,
+                                          ring > SIGNS_RING_CHUNKS ? ring : SIGNS_RING_CHUNKS);
+    }
+    int status = 0;
+    if (!job.counts || (labels && (!job.signs || !job.worker_out || !job.writer))) {
+        printf("Error: Out of memory.\n");
+        status = 1;
     } else {
-        printf("Physically, it's a relatively normal day. ");
+        double start = stopwatch_seconds();
+        // Labels go through the ordered writer, so their chunks must start in order.
+        if (labels) pool_run_ordered(num_threads, num_chunks, run_signs_chunk, &job);
+        else pool_run(num_threads, num_chunks, run_signs_chunk, &job);
+        double seconds = stopwatch_seconds() - start;
+        fprintf(stderr, "Classified %zu dates in %.1f ms (%.1f M dates/s on %d threads).\n", users.count,
+                seconds * 1e3, seconds > 0 ? users.count / seconds / 1e6 : 0.0, num_threads);
     }
 
-    if (emotional > 50) {
-        printf(COLOR_GREEN "Emotionally, you're likely feeling positive and creative. " COLOR_RESET);
-    } else if (emotional < -50) {
-        printf(COLOR_RED "Emotionally, you may be feeling sensitive or withdrawn. " COLOR_RESET);
+    if (labels) {
+        int failed = job.writer && ordered_writer_finish(job.writer) != 0;
+        failed |= output_close(&output) != 0;
+        if (failed) {
+            fprintf(stderr, "Error: Could not write sign labels.\n");
+            status = 1;
+        }
+        if (job.worker_out) {
+            for (int t = 0; t < num_threads; t++) outbuf_free(&job.worker_out[t]);
+        }
+    } else if (status == 0) {
+        uint64_t counts[13] = { 0 };
+        for (int t = 0; t < num_threads; t++) {
+            for (int s = 0; s < 13; s++) counts[s] += job.counts[t][s];
+        }
+        printf("# Sun signs of %zu users (%llu born outside %d-%d)\n", users.count,
+               (unsigned long long)counts[INGRESS_NO_SIGN], INGRESS_FIRST_YEAR, INGRESS_LAST_YEAR);
+        for (int s = 0; s < 12; s++) {
+            printf("%s\t%llu\t%.1f%%\n", sun_sign_names[s], (unsigned long long)counts[s],
+                   users.count ? 100.0 * counts[s] / users.count : 0.0);
+        }
+    }
+
+    free(job.worker_out);
+    free(job.signs);
+    free(job.counts);
+    records_free(&users);
+    return status;
+}
+
+// --- Forecast Service ---
+#define SERVE_RETRY_SECONDS 60 // Wait before retrying a failed snapshot refresh
+#define SERVE_SETTLE_SECONDS 5 // Delay past UTC midnight before fetching the new day
+#define SERVE_RECLAIM_NS 1000000 // Pause between attempts to free a replaced snapshot
+
+// Everything a forecast request needs from the day's sky, built once per day
+// and immutable once published.
+struct ForecastSnapshot {
+    struct Snapshot base;
+    long jdn;
+    struct PlanetSeries positions; // Today and tomorrow, for speeds
+    struct ForecastMemo memo;      // Sky and rendered forecast text per Sun sign
+};
+
+struct ForecastService {
+    const struct Planet *planets;
+    const char *const *body_ids;
+    int num_planets;
+    struct SnapshotCell cell;          // Read by the HTTP workers, one reader slot each
+    const struct ForecastSnapshot *published; // The refresher's view of the current snapshot
+    pthread_mutex_t stop_lock;
+    pthread_cond_t stop_cond;
+    int stopping;
+    pthread_t refresher;
+};
+
+static void forecast_snapshot_destroy(struct Snapshot *s) {
+    struct ForecastSnapshot *snap = (struct ForecastSnapshot *)s;
+    forecast_memo_free(&snap->memo);
+    planet_series_free(&snap->positions);
+    free(snap);
+}
+
+// Fetches a day's positions and renders its twelve forecasts. Returns NULL
+// unless every body was fetched.
+static struct ForecastSnapshot *forecast_snapshot_build(const struct ForecastService *svc, CURL *curl, long jdn) {
+    struct ForecastSnapshot *snap = malloc(sizeof(*snap));
+    if (!snap) return NULL;
+    if (planet_series_init(&snap->positions, svc->num_planets, 2) != 0) {
+        free(snap);
+        return NULL;
+    }
+    snapshot_init(&snap->base, forecast_snapshot_destroy);
+    forecast_memo_init(&snap->memo, &plain_tpl);
+    int cached;
+    if (fetch_positions(curl, svc->body_ids, jdn, &snap->positions, &cached) != svc->num_planets) {
+        snapshot_release(&snap->base);
+        return NULL;
+    }
+    struct PlanetSlice day = planet_series_day(&snap->positions, 0);
+    forecast_memo_update(&snap->memo, svc->planets, &day, find_body(svc->planets, svc->num_planets, "Sun"), jdn);
+    snap->jdn = jdn;
+    return snap;
+}
+
+// Sleeps until shortly after the next UTC midnight, or SERVE_RETRY_SECONDS
+// after a failure, then publishes a snapshot for the new day.
+static void *snapshot_refresher(void *arg) {
+    struct ForecastService *svc = arg;
+    CURL *curl = curl_easy_init();
+    int failed = 0;
+    pthread_mutex_lock(&svc->stop_lock);
+    while (!svc->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec = failed ? deadline.tv_sec + SERVE_RETRY_SECONDS
+                                 : (jd_today_utc() + 1 - JD_UNIX_EPOCH) * 86400L + SERVE_SETTLE_SECONDS;
+        deadline.tv_nsec = 0;
+        int timed_out = 0;
+        while (!svc->stopping && !timed_out) {
+            timed_out = pthread_cond_timedwait(&svc->stop_cond, &svc->stop_lock, &deadline) == ETIMEDOUT;
+        }
+        if (svc->stopping) break;
+        pthread_mutex_unlock(&svc->stop_lock);
+
+        long today = jd_today_utc();
+        int stale = svc->published->jdn != today;
+        struct ForecastSnapshot *fresh = stale && curl ? forecast_snapshot_build(svc, curl, today) : NULL;
+        failed = stale && !fresh;
+        char date_str[11];
+        jd_format(today, date_str);
+        if (fresh) {
+            svc->published = fresh;
+            snapshot_publish(&svc->cell, &fresh->base);
+            // Requests take microseconds, so the old snapshot frees almost at once.
+            struct timespec pause = { 0, SERVE_RECLAIM_NS };
+            while (snapshot_reclaim(&svc->cell) > 0) nanosleep(&pause, NULL);
+            fprintf(stderr, "Snapshot refreshed for %s.\n", date_str);
+        } else if (failed) {
+            fprintf(stderr, "Error: Could not refresh the snapshot for %s; retrying in %d s.\n", date_str,
+                    SERVE_RETRY_SECONDS);
+        }
+        pthread_mutex_lock(&svc->stop_lock);
+    }
+    pthread_mutex_unlock(&svc->stop_lock);
+    if (curl) curl_easy_cleanup(curl);
+    return NULL;
+}
+
+static void service_error(struct HttpResponse *res, int status, int json, const char *message) {
+    res->status = status;
+    if (json) {
+        res->content_type = "application/json";
+        struct JsonWriter w;
+        jsonw_init(&w, res->body);
+        jsonw_begin_object(&w);
+        jsonw_key(&w, "error");
+        jsonw_string(&w, message);
+        jsonw_end_object(&w);
+        outbuf_putc(res->body, '\n');
     } else {
-        printf("Emotionally, things are on an even keel. ");
+        outbuf_printf(res->body, "Error: %s\n", message);
     }
+}
+
+// GET /forecast?birth=YYYY-MM-DD[&time=HH:MM][&format=json|text]: the same
+// forecast and biorhythm report as the console, for today's snapshot.
+static void service_forecast(struct ForecastService *svc, const struct HttpRequest *req, struct HttpResponse *res) {
+    char birth[16], time_str[8], format[8];
+    int json = http_query_param(req, "format", format, sizeof(format)) < 0 || strcmp(format, "json") == 0;
+    if (!json && strcmp(format, "text") != 0) {
+        service_error(res, 400, 1, "format must be json or text");
+        return;
+    }
+    if (json) res->content_type = "application/json";
 
-    if (intellectual > 50) {
-        printf(COLOR_GREEN "Intellectually, your mind is sharp and clear. " COLOR_RESET);
-    } else if (intellectual < -50) {
-        printf(COLOR_RED "Intellectually, it might be a good day for rest rather than complex tasks. " COLOR_RESET);
+    long birth_jdn;
+    int year, month, day, birth_minute = -1;
+    if (http_query_param(req, "birth", birth, sizeof(birth)) < 0 || jd_parse(birth, &birth_jdn) != 0) {
+        service_error(res, 400, json, "birth must be a date as YYYY-MM-DD");
+        return;
+    }
+    if (http_query_param(req, "time", time_str, sizeof(time_str)) >= 0) {
+        int hour, minute, len = 0;
+        if (sscanf(time_str, "%2d:%2d%n", &hour, &minute, &len) != 2 || time_str[len] != '\0' || hour < 0 ||
+            hour > 23 || minute < 0 || minute > 59) {
+            service_error(res, 400, json, "time must be HH:MM");
+            return;
+        }
+        birth_minute = hour * 60 + minute;
+    }
+    jd_to_civil(birth_jdn, &year, &month, &day);
+    int sun_sign_idx = ingress_sign(year, month, day);
+    if (sun_sign_idx < 0) {
+        service_error(res, 422, json, "birth date outside the supported years");
+        return;
+    }
+
+    const struct ForecastSnapshot *snap = (const struct ForecastSnapshot *)snapshot_enter(&svc->cell, req->worker);
+    if (birth_jdn > snap->jdn) {
+        snapshot_leave(&svc->cell, req->worker);
+        service_error(res, 422, json, "birth date is in the future");
+        return;
+    }
+    struct Forecast f = snap->memo.sky[sun_sign_idx];
+    // The request's time of day, on the snapshot's date.
+    double day_fraction;
+    jd_now_utc(&day_fraction);
+    forecast_compute_biorhythm_on(&f, year, month, day, birth_minute, snap->jdn, day_fraction);
+    if (json) {
+        char date_str[11];
+        struct JsonWriter w;
+        jsonw_init(&w, res->body);
+        jsonw_begin_object(&w);
+        jsonw_key(&w, "birth_date");
+        jsonw_string(&w, birth);
+        jsonw_key(&w, "date");
+        jd_format(snap->jdn, date_str);
+        jsonw_string(&w, date_str);
+        generate_forecast_json(&w, svc->planets, &f);
+        jsonw_end_object(&w);
+        outbuf_putc(res->body, '\n');
     } else {
-         printf("Intellectually, your focus is stable. ");
+        outbuf_printf(res->body, "Your true Sun sign is %s.\n", sun_sign_names[sun_sign_idx]);
+        const struct OutBuf *forecast = &snap->memo.text[sun_sign_idx];
+        outbuf_write(res->body, forecast->data, forecast->len);
+        render_final_report(res->body, &plain_tpl, &f);
     }
-    
-    printf("\n----------------------------\n");
+    snapshot_leave(&svc->cell, req->worker);
+}
+
+static void service_handle(void *ctx, const struct HttpRequest *req, struct HttpResponse *res) {
+    struct ForecastService *svc = ctx;
+    if (req->path_len == 9 && memcmp(req->path, "/forecast", 9) == 0) {
+        service_forecast(svc, req, res);
+    } else if (req->path_len == 7 && memcmp(req->path, "/health", 7) == 0) {
+        char date_str[11];
+        const struct ForecastSnapshot *snap = (const struct ForecastSnapshot *)snapshot_enter(&svc->cell, req->worker);
+        jd_format(snap->jdn, date_str);
+        snapshot_leave(&svc->cell, req->worker);
+        outbuf_printf(res->body, "ok %s\n", date_str);
+    } else {
+        res->status = 404;
+        outbuf_puts(res->body, "Not Found\n");
+    }
+}
+
+// Serves forecasts over HTTP on [ADDR:]PORT until interrupted.
+int run_serve(const char *listen, const struct Planet planets[], const char *const body_ids[], int num_planets,
+              int num_threads) {
+    char address[64] = "127.0.0.1";
+    const char *colon = strrchr(listen, ':');
+    if (colon) {
+        if ((size_t)(colon - listen) >= sizeof(address)) {
+            printf("Error: Invalid --serve address.\n");
+            return 1;
+        }
+        memcpy(address, listen, colon - listen);
+        address[colon - listen] = '\0';
+    }
+    struct HttpdConfig config = {
+        .address = address, .port = atoi(colon ? colon + 1 : listen), .num_threads = num_threads,
+        .handler = service_handle
+    };
+    if (config.port < 1 || config.port > 65535) {
+        printf("Error: Invalid --serve port.\n");
+        return 1;
+    }
+
+    ingress_init();
+    curl_global_init(CURL_GLOBAL_ALL);
+    struct ForecastService svc = {
+        .planets = planets, .body_ids = body_ids, .num_planets = num_planets,
+        .stop_lock = PTHREAD_MUTEX_INITIALIZER, .stop_cond = PTHREAD_COND_INITIALIZER
+    };
+    CURL *curl = curl_easy_init();
+    struct ForecastSnapshot *initial = curl ? forecast_snapshot_build(&svc, curl, jd_today_utc()) : NULL;
+    if (curl) curl_easy_cleanup(curl);
+    if (!initial) {
+        printf("Error: Could not fetch today's planetary data from NASA.\n");
+        curl_global_cleanup();
+        return 1;
+    }
+    svc.published = initial;
+    if (snapshot_cell_init(&svc.cell, num_threads, &initial->base) != 0) {
+        printf("Error: Out of memory.\n");
+        snapshot_release(&initial->base);
+        curl_global_cleanup();
+        return 1;
+    }
+    config.ctx = &svc;
+
+    // The refresher must not take the shutdown signals httpd_run() waits for.
+    sigset_t signals, old_mask;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &old_mask);
+    int refreshing = pthread_create(&svc.refresher, NULL, snapshot_refresher, &svc) == 0;
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+    int status = httpd_run(&config) == 0 ? 0 : 1;
+
+    if (refreshing) {
+        pthread_mutex_lock(&svc.stop_lock);
+        svc.stopping = 1;
+        pthread_cond_signal(&svc.stop_cond);
+        pthread_mutex_unlock(&svc.stop_lock);
+        pthread_join(svc.refresher, NULL);
+    }
+    snapshot_cell_destroy(&svc.cell);
+    curl_global_cleanup();
+    return status;
+}
+
+// --- Date Range Mode ---
+#define RANGE_MAX_DAYS    36525       // A century; bounds the ranged Horizons responses
+#define RANGE_FLUSH_BYTES (64 * 1024) // Rendered days held before a write
+
+// Renders one user's forecast for every day from first_jdn to last_jdn. Positions
+// for the whole window come from one ranged request per body; the forecast and
+// report buffer are reused, so each further day costs only computation.
+int run_range(CURL *curl, const struct Planet planets[], const char *const body_ids[], int num_planets,
+              int sun_sign_idx, int year, int month, int day, long first_jdn, long last_jdn,
+              enum OutputFormat format, const char *output_path) {
+    int num_days = (int)(last_jdn - first_jdn + 1);
+    struct PlanetSeries positions;
+    // One extra day gives the last day of the window its speeds.
+    if (planet_series_init(&positions, num_planets, num_days + 1) != 0) {
+        printf("Error: Out of memory.\n");
+        return 1;
+    }
+    // Arbitrary windows are not shared: each would leave its own segment
+    // behind, while the daily cache retires the previous day's.
+    int fetched = horizons_fetch_series(curl, body_ids, first_jdn, &positions);
+    if (fetched < num_planets) {
+        printf("Error: Only %d of %d bodies were fetched; not writing forecasts from incomplete positions.\n",
+               fetched, num_planets);
+        planet_series_free(&positions);
+        return 1;
+    }
+
+    struct OutputFile output;
+    // Reports bypass stdio, so the prompts already buffered must go first.
+    fflush(stdout);
+    if (output_open(&output, output_path) != 0) {
+        planet_series_free(&positions);
+        return 1;
+    }
+
+    // The window's calendar dates, converted in one vectorizable pass.
+    long *days = malloc(num_days * sizeof(*days));
+    int *civil = malloc(3 * (size_t)num_days * sizeof(*civil));
+    if (!days || !civil) {
+        printf("Error: Out of memory.\n");
+        free(days);
+        free(civil);
+        output_close(&output);
+        planet_series_free(&positions);
+        return 1;
+    }
+    int *years = civil, *months = civil + num_days, *mdays = civil + 2 * num_days;
+    jd_range(first_jdn, num_days, days);
+    jd_to_civil_n(days, num_days, years, months, mdays);
+
+    double start = stopwatch_seconds();
+    int sun_body = find_body(planets, num_planets, "Sun");
+    char birth_str[11], date_str[11];
+    jd_format(jd_from_civil(year, month, day), birth_str);
+    struct Forecast forecast;
+    struct OutBuf out;
+    outbuf_init(&out);
+    int failed = 0;
+    if (format == FORMAT_JSON) outbuf_puts(&out, "[\n");
+
+    for (int d = 0; d < num_days && !failed; d++) {
+        struct PlanetSlice sky = planet_series_day(&positions, d);
+        forecast_compute_sky(&forecast, &sky, sun_sign_idx, sun_body);
+        forecast_compute_biorhythm_on(&forecast, year, month, day, -1, days[d], 0.0);
+        jd_format_civil(years[d], months[d], mdays[d], date_str);
+
+        if (format == FORMAT_TEXT) {
+            outbuf_printf(&out, "\n=== %s ===\n", date_str);
+            generate_forecast(&out, planets, &forecast);
+            generate_final_report(&out, &forecast);
+        } else {
+            if (format == FORMAT_JSON && d > 0) outbuf_write(&out, ",\n", 2);
+            struct JsonWriter w;
+            jsonw_init(&w, &out);
+            jsonw_begin_object(&w);
+            jsonw_key(&w, "birth_date");
+            jsonw_string(&w, birth_str);
+            jsonw_key(&w, "date");
+            jsonw_string(&w, date_str);
+            generate_forecast_json(&w, planets, &forecast);
+            jsonw_end_object(&w);
+            if (format == FORMAT_NDJSON) outbuf_putc(&out, '\n');
+        }
+
+        if (out.len >= RANGE_FLUSH_BYTES) {
+            failed = output_write(&output, out.data, out.len) != 0;
+            out.len = 0;
+        }
+    }
+    if (format == FORMAT_JSON) outbuf_puts(&out, "\n]\n");
+    if (!failed) failed = output_write(&output, out.data, out.len) != 0;
+    failed |= output_close(&output) != 0;
+    double seconds = stopwatch_seconds() - start;
+
+    fprintf(stderr, "Range: %d days from %d Horizons requests (%d of %d bodies fetched), rendered in %.1f ms (%.2f us/day).\n",
+            num_days, num_planets, fetched, num_planets, seconds * 1e3, seconds * 1e6 / num_days);
+    if (failed) fprintf(stderr, "Error: Could not write forecasts.\n");
+    outbuf_free(&out);
+    free(days);
+    free(civil);
+    planet_series_free(&positions);
+    return failed ? 1 : 0;
+}
+
+// --- Report Benchmark ---
+// Counts the write calls a stdio stream issues; stands in for a descriptor.
+static ssize_t bench_count_write(void *cookie, const char *buf, size_t size) {
+    (void)buf;
+    (*(long *)cookie)++;
+    return size;
+}
+
+static FILE *bench_stream(long *writes, int mode) {
+    cookie_io_functions_t io = { .write = bench_count_write };
+    FILE *f = fopencookie(writes, "w", io);
+    if (f) setvbuf(f, NULL, mode, BUFSIZ);
+    return f;
+}
+
+static uint64_t bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// The pre-glyph-table bar: one stdio call per cell.
+static void bench_stdio_line(FILE *f, const char *label, double value) {
+    int scaled_value = (int)(value / 100.0 * BAR_WIDTH);
+    fprintf(f, "%s%4.0f%% [", label, value);
+    if (scaled_value >= 0) {
+        for (int i = 0; i < BAR_WIDTH; ++i) fprintf(f, " ");
+        fprintf(f, "|");
+        for (int i = 0; i < scaled_value; ++i) fprintf(f, "+");
+        for (int i = 0; i < BAR_WIDTH - scaled_value; ++i) fprintf(f, " ");
+    } else {
+        for (int i = 0; i < BAR_WIDTH + scaled_value; ++i) fprintf(f, " ");
+        for (int i = 0; i < -scaled_value; ++i) fprintf(f, "-");
+        fprintf(f, "|");
+        for (int i = 0; i < BAR_WIDTH; ++i) fprintf(f, " ");
+    }
+    fprintf(f, "]\n");
 }
 
-int main(void) {
+static void bench_report(const char *what, int reports, double seconds, uint64_t cycles, long writes) {
+    printf("  %-28s %8.0f ns/report", what, seconds * 1e9 / reports);
+    if (cycles) printf("  %8.0f cycles/report", (double)cycles / reports);
+    printf("  %6.1f writes/report\n", (double)writes / reports);
+}
+
+// Runs each output path over the same forecasts; the counters belong to the
+// sinks, so each path reports the writes it added.
+static void bench_paths(const struct Planet planets[], struct Forecast *f, int reports, FILE *line_sink,
+                        const long *line_writes, FILE *report_sink, const long *report_writes) {
+    struct OutBuf out;
+    outbuf_init(&out);
+    printf("Biorhythm block (3 bars and percentages):\n");
+    long w0 = *line_writes;
+    double t0 = stopwatch_seconds();
+    uint64_t c0 = bench_cycles();
+    for (int r = 0; r < reports; r++) {
+        biorhythm_lookup(10000 + r, &f->bio);
+        bench_stdio_line(line_sink, "Physical:     ", f->bio.physical);
+        bench_stdio_line(line_sink, "Emotional:    ", f->bio.emotional);
+        bench_stdio_line(line_sink, "Intellectual: ", f->bio.intellectual);
+    }
+    fflush(line_sink);
+    bench_report("stdio call per cell", reports, stopwatch_seconds() - t0, bench_cycles() - c0, *line_writes - w0);
+
+    w0 = *report_writes;
+    t0 = stopwatch_seconds();
+    c0 = bench_cycles();
+    for (int r = 0; r < reports; r++) {
+        biorhythm_lookup(10000 + r, &f->bio);
+        out.len = 0;
+        print_biorhythm_line(&out, "Physical:     ", f->bio.physical);
+        print_biorhythm_line(&out, "Emotional:    ", f->bio.emotional);
+        print_biorhythm_line(&out, "Intellectual: ", f->bio.intellectual);
+        fwrite(out.data, 1, out.len, report_sink);
+    }
+    bench_report("glyph table + fixed format", reports, stopwatch_seconds() - t0, bench_cycles() - c0,
+                 *report_writes - w0);
+
+    printf("Whole report (forecast and summary) to the OS:\n");
+    w0 = *line_writes;
+    t0 = stopwatch_seconds();
+    c0 = bench_cycles();
+    for (int r = 0; r < reports; r++) {
+        biorhythm_lookup(10000 + r, &f->bio);
+        out.len = 0;
+        generate_forecast(&out, planets, f);
+        generate_final_report(&out, f);
+        // Emitted line by line, as the printf-based report reached a terminal.
+        for (char *line = out.data, *nl; (nl = memchr(line, '\n', out.data + out.len - line)); line = nl + 1) {
+            fwrite(line, 1, nl + 1 - line, line_sink);
+        }
+    }
+    fflush(line_sink);
+    bench_report("line-buffered stdio", reports, stopwatch_seconds() - t0, bench_cycles() - c0, *line_writes - w0);
+
+    w0 = *report_writes;
+    t0 = stopwatch_seconds();
+    c0 = bench_cycles();
+    for (int r = 0; r < reports; r++) {
+        biorhythm_lookup(10000 + r, &f->bio);
+        out.len = 0;
+        generate_forecast(&out, planets, f);
+        generate_final_report(&out, f);
+        fwrite(out.data, 1, out.len, report_sink);
+    }
+    bench_report("one write per report", reports, stopwatch_seconds() - t0, bench_cycles() - c0,
+                 *report_writes - w0);
+    outbuf_free(&out);
+}
+
+// Times report assembly and output on synthetic positions; needs no network.
+// Old and new paths are measured side by side, and the number of write calls
+// each would issue on a terminal is counted through an instrumented stream.
+int run_bench(const struct Planet planets[], int num_planets, int reports) {
+    struct PlanetSeries sky;
+    if (planet_series_init(&sky, num_planets, 1) != 0) {
+        printf("Error: Out of memory.\n");
+        return 1;
+    }
+    for (int i = 0; i < num_planets; i++) planet_series_set(&sky, i, 0, BAM_DEG(37.0 * i + 11.0), 0.0f);
+    planet_series_finish(&sky);
+    struct PlanetSlice day = planet_series_day(&sky, 0);
+    struct Forecast f;
+    forecast_compute_sky(&f, &day, 0, find_body(planets, num_planets, "Sun"));
+
+    long line_writes = 0, report_writes = 0;
+    FILE *line_sink = bench_stream(&line_writes, _IOLBF);   // stdout on a terminal
+    FILE *report_sink = bench_stream(&report_writes, _IONBF);
+    int status = 0;
+    if (!line_sink || !report_sink) {
+        printf("Error: Could not create benchmark streams.\n");
+        status = 1;
+    } else {
+        printf("Report benchmark, %d reports\n", reports);
+        bench_paths(planets, &f, reports, line_sink, &line_writes, report_sink, &report_writes);
+    }
+
+    if (line_sink) fclose(line_sink);
+    if (report_sink) fclose(report_sink);
+    planet_series_free(&sky);
+    return status;
+}
+
+enum {
+    OPT_CHART = 256,
+    OPT_CHART_OUT,
+    OPT_CHART_USERS,
+    OPT_CALENDAR,
+    OPT_POPULATION,
+    OPT_QUERY,
+    OPT_QUERY_DAYS,
+    OPT_COMPAT,
+    OPT_COMPAT_WITH,
+    OPT_BATCH,
+    OPT_THREADS,
+    OPT_FORMAT,
+    OPT_BENCH,
+    OPT_TEMPLATES,
+    OPT_EXPORT,
+    OPT_OUTPUT,
+    OPT_FROM,
+    OPT_TO,
+    OPT_SIGNS,
+    OPT_LABELS,
+    OPT_SERVE,
+    OPT_NO_CACHE
+};
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"chart", required_argument, NULL, OPT_CHART},
+        {"chart-out", required_argument, NULL, OPT_CHART_OUT},
+        {"chart-users", required_argument, NULL, OPT_CHART_USERS},
+        {"calendar", required_argument, NULL, OPT_CALENDAR},
+        {"population", required_argument, NULL, OPT_POPULATION},
+        {"query", required_argument, NULL, OPT_QUERY},
+        {"query-days", required_argument, NULL, OPT_QUERY_DAYS},
+        {"compat", required_argument, NULL, OPT_COMPAT},
+        {"compat-with", required_argument, NULL, OPT_COMPAT_WITH},
+        {"batch", required_argument, NULL, OPT_BATCH},
+        {"threads", required_argument, NULL, OPT_THREADS},
+        {"format", required_argument, NULL, OPT_FORMAT},
+        {"bench", required_argument, NULL, OPT_BENCH},
+        {"templates", required_argument, NULL, OPT_TEMPLATES},
+        {"export", required_argument, NULL, OPT_EXPORT},
+        {"output", required_argument, NULL, OPT_OUTPUT},
+        {"from", required_argument, NULL, OPT_FROM},
+        {"to", required_argument, NULL, OPT_TO},
+        {"signs", required_argument, NULL, OPT_SIGNS},
+        {"labels", no_argument, NULL, OPT_LABELS},
+        {"serve", required_argument, NULL, OPT_SERVE},
+        {"no-cache", no_argument, NULL, OPT_NO_CACHE},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int chart_days = 0;
+    const char *chart_path = NULL;
+    const char *chart_users_path = NULL;
+    int calendar_days = 0;
+    const char *population_path = NULL;
+    const char *population_query = "triple-high";
+    int query_days = 1;
+    const char *compat_path = NULL;
+    const char *compat_with = NULL;
+    const char *batch_path = NULL;
+    int num_threads = pool_default_threads();
+    enum OutputFormat format = FORMAT_TEXT;
+    int bench_reports = 0;
+    const char *templates_path = NULL;
+    const char *export_path = NULL;
+    const char *output_path = NULL;
+    long range_from = 0, range_to = 0;
+    const char *signs_path = NULL;
+    int sign_labels = 0;
+    const char *serve_listen = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case OPT_CHART:
+            chart_days = atoi(optarg);
+            if (chart_days < 1) {
+                printf("Invalid --chart day count.\n");
+                return 1;
+            }
+            break;
+        case OPT_CHART_OUT:
+            chart_path = optarg;
+            break;
+        case OPT_CHART_USERS:
+            chart_users_path = optarg;
+            break;
+        case OPT_CALENDAR:
+            calendar_days = atoi(optarg);
+            if (calendar_days < 1) {
+                printf("Invalid --calendar day count.\n");
+                return 1;
+            }
+            break;
+        case OPT_POPULATION:
+            population_path = optarg;
+            break;
+        case OPT_QUERY:
+            population_query = optarg;
+            break;
+        case OPT_QUERY_DAYS:
+            query_days = atoi(optarg);
+            if (query_days < 1) {
+                printf("Invalid --query-days count.\n");
+                return 1;
+            }
+            break;
+        case OPT_COMPAT:
+            compat_path = optarg;
+            break;
+        case OPT_COMPAT_WITH:
+            compat_with = optarg;
+            break;
+        case OPT_BATCH:
+            batch_path = optarg;
+            break;
+        case OPT_THREADS:
+            num_threads = atoi(optarg);
+            if (num_threads < 1) {
+                printf("Invalid --threads count.\n");
+                return 1;
+            }
+            break;
+        case OPT_FORMAT:
+            if (strcmp(optarg, "text") == 0) {
+                format = FORMAT_TEXT;
+            } else if (strcmp(optarg, "json") == 0) {
+                format = FORMAT_JSON;
+            } else if (strcmp(optarg, "ndjson") == 0) {
+                format = FORMAT_NDJSON;
+            } else {
+                printf("Invalid --format; use text, json or ndjson.\n");
+                return 1;
+            }
+            break;
+        case OPT_BENCH:
+            bench_reports = atoi(optarg);
+            if (bench_reports < 1) {
+                printf("Invalid --bench report count.\n");
+                return 1;
+            }
+            break;
+        case OPT_TEMPLATES:
+            templates_path = optarg;
+            break;
+        case OPT_EXPORT:
+            export_path = optarg;
+            break;
+        case OPT_OUTPUT:
+            output_path = optarg;
+            break;
+        case OPT_SIGNS:
+            signs_path = optarg;
+            break;
+        case OPT_LABELS:
+            sign_labels = 1;
+            break;
+        case OPT_SERVE:
+            serve_listen = optarg;
+            break;
+        case OPT_NO_CACHE:
+            use_shared_cache = 0;
+            break;
+        case OPT_FROM:
+            if (jd_parse(optarg, &range_from) != 0) {
+                printf("Invalid --from date; use YYYY-MM-DD.\n");
+                return 1;
+            }
+            break;
+        case OPT_TO:
+            if (jd_parse(optarg, &range_to) != 0) {
+                printf("Invalid --to date; use YYYY-MM-DD.\n");
+                return 1;
+            }
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // A lone --from is a single day; a lone --to starts today.
+    if (range_from || range_to) {
+        if (!range_from) range_from = jd_today_utc();
+        if (!range_to) range_to = range_from;
+        if (range_to < range_from || range_to - range_from >= RANGE_MAX_DAYS) {
+            printf("Invalid date range; --to must follow --from by less than %d days.\n", RANGE_MAX_DAYS);
+            return 1;
+        }
+        if (range_from < jd_from_civil(1, 1, 1)) {
+            printf("Invalid date range; dates start at 0001-01-01.\n");
+            return 1;
+        }
+    }
+
     struct Planet planets[] = {
         {"Sun", "10"}, {"Moon", "301"}, {"Mercury", "199"}, {"Venus", "299"},
         {"Mars", "499"}, {"Jupiter", "599"}, {"Saturn", "699"}, {"Uranus", "799"},
         {"Neptune", "899"}, {"Pluto", "999"}
     };
     int num_planets = sizeof(planets) / sizeof(planets[0]);
-    for(int i=0; i<num_planets; ++i) planets[i].keyword = planet_keywords[i];
+    const char *body_ids[sizeof(planets) / sizeof(planets[0])];
+    for(int i=0; i<num_planets; ++i) {
+        body_ids[i] = planets[i].id;
+    }
+    if (load_report_templates(templates_path, planets, num_planets) != 0) {
+        return 1;
+    }
+    biorhythm_init();
+    init_bar_glyphs();
+
+    // --- Report Benchmark Mode ---
+    if (bench_reports > 0) {
+        return run_bench(planets, num_planets, bench_reports);
+    }
+
+    // --- Biorhythm Series for a User File ---
+    if (chart_users_path) {
+        if (chart_days < 1 || !chart_path) {
+            printf("--chart-users needs --chart=N and --chart-out=FILE.\n");
+            return 1;
+        }
+        return run_chart_users(chart_users_path, chart_days, chart_path, num_threads);
+    }
+
+    // --- Batch Mode ---
+    if (batch_path) {
+        return run_batch(batch_path, planets, body_ids, num_planets, num_threads, format, output_path, export_path);
+    }
+
+    // --- Forecast Service Mode ---
+    if (serve_listen) {
+        return run_serve(serve_listen, planets, body_ids, num_planets, num_threads);
+    }
+
+    // --- Sun Sign Analytics Mode ---
+    if (signs_path) {
+        return run_signs(signs_path, sign_labels, num_threads, output_path);
+    }
+
+    // --- Compatibility Mode ---
+    if (compat_path) {
+        return run_compatibility(compat_path, compat_with, num_threads);
+    }
+
+    // --- Population Query Mode ---
+    if (population_path) {
+        return run_population_query(population_path, population_query, query_days, num_threads);
+    }
 
     // --- Get User Input for Birth Date ---
     int year, month, day;
-    printf("Please enter your birth date.\n");
-    printf("Year (e.g., 1990): ");
-    scanf("%d", &year);
-    printf("Month (1-12): ");
-    scanf("%d", &month);
-    printf("Day (1-31): ");
-    scanf("%d", &day);
-
-    if (year < 1900 || year > 2024 || month < 1 || month > 12 || day < 1 || day > 31) {
+    if (read_birth_date(&year, &month, &day) != 0) {
         printf("Invalid date. Exiting.\n");
         return 1;
     }
 
-    // --- Calculate User's Sun Sign ---
-    double earth_longitude_at_birth = 0.0;
-    printf("\nCalculating your true Sun sign from NASA data...\n");
+    // --- Biorhythm Chart Mode ---
+    if (chart_days > 0) {
+        struct BiorhythmSample *series = malloc(chart_days * sizeof(*series));
+        if (!series) {
+            printf("Error: Out of memory.\n");
+            return 1;
+        }
+        biorhythm_series(days_alive_today(year, month, day), chart_days, series);
+        print_biorhythm_chart(series, chart_days);
+        int status = 0;
+        if (chart_path && write_biorhythm_series(chart_path, series, chart_days) != 0) {
+            printf("Error: Could not write %s.\n", chart_path);
+            status = 1;
+        }
+        free(series);
+        return status;
+    }
 
-    char birth_date_str[11];
-    snprintf(birth_date_str, sizeof(birth_date_str), "%04d-%02d-%02d", year, month, day);
+    // --- Biorhythm Calendar Mode ---
+    if (calendar_days > 0) {
+        if (print_biorhythm_calendar(year, month, day, calendar_days) != 0) {
+            printf("Error: Out of memory.\n");
+            return 1;
+        }
+        return 0;
+    }
 
-    struct tm birth_tm = {0};
-    birth_tm.tm_year = year - 1900;
-    birth_tm.tm_mon = month - 1;
-    birth_tm.tm_mday = day;
-    time_t birth_t = mktime(&birth_tm);
-    birth_t += 24 * 60 * 60;
-    struct tm *next_day_tm = localtime(&birth_t);
-    char next_day_str[11];
-    strftime(next_day_str, sizeof(next_day_str), "%Y-%m-%d", next_day_tm);
+    // --- Calculate User's Sun Sign ---
+    printf("\nCalculating your true Sun sign from NASA data...\n");
 
     curl_global_init(CURL_GLOBAL_ALL);
     CURL *curl_handle = curl_easy_init();
-    if (curl_handle) {
-        struct MemoryStruct chunk = { .memory = malloc(1), .size = 0 };
-        char url[512];
-        snprintf(url, sizeof(url),
-                 "https://ssd.jpl.nasa.gov/api/horizons.api?format=json&COMMAND='399'&OBJ_DATA='NO'&MAKE_EPHEM='YES'&EPHEM_TYPE='VECTORS'&CENTER='@sun'&START_TIME='%s'&STOP_TIME='%s'&STEP_SIZE='1d'&VEC_TABLE='1'",
-                 birth_date_str, next_day_str);
-
-        curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl_handle, CURLOPT_URL, url);
-        curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-        curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
-        if (curl_easy_perform(curl_handle) == CURLE_OK) {
-            if (parse_planet_data(chunk.memory, &earth_longitude_at_birth) != 0) {
-                 printf("Error: Could not calculate Sun Sign. The NASA API might be temporarily unavailable or the date is invalid.\n");
-                 curl_easy_cleanup(curl_handle);
-                 free(chunk.memory);
-                 curl_global_cleanup();
-                 return 1;
-            }
-        } else {
-            printf("Error: API call failed during Sun Sign calculation.\n");
-            curl_easy_cleanup(curl_handle);
-            free(chunk.memory);
-            curl_global_cleanup();
-            return 1;
-        }
+    if (!curl_handle) {
+        printf("Error: Could not initialise the HTTP client.\n");
+        curl_global_cleanup();
+        return 1;
+    }
+
+    bam32_t sun_longitude_at_birth;
+    int status = horizons_sun_longitude(curl_handle, jd_from_civil(year, month, day), &sun_longitude_at_birth);
+    if (status == HORIZONS_ERR_PARSE) {
+        printf("Error: Could not calculate Sun Sign. The NASA API might be temporarily unavailable or the date is invalid.\n");
+    } else if (status != 0) {
+        printf("Error: API call failed during Sun Sign calculation.\n");
+    }
+    if (status != 0) {
         curl_easy_cleanup(curl_handle);
-        free(chunk.memory);
+        curl_global_cleanup();
+        return 1;
     }
-    
-    double sun_longitude_at_birth = earth_longitude_at_birth + 180;
-    if (sun_longitude_at_birth >= 360) sun_longitude_at_birth -= 360;
     int sun_sign_idx = get_zodiac_index(sun_longitude_at_birth);
-    const char* sun_sign_names[] = {"Aries", "Taurus", "Gemini", "Cancer", "Leo", "Virgo", "Libra", "Scorpio", "Sagittarius", "Capricorn", "Aquarius", "Pisces"};
     printf("Your true Sun sign is %s.\n", sun_sign_names[sun_sign_idx]);
 
 
+    // --- Date Range Mode ---
+    if (range_from) {
+        char from_str[11], to_str[11];
+        jd_format(range_from, from_str);
+        jd_format(range_to, to_str);
+        printf("\nFetching planetary data for %s to %s from NASA...\n", from_str, to_str);
+        status = run_range(curl_handle, planets, body_ids, num_planets, sun_sign_idx, year, month, day,
+                           range_from, range_to, format, output_path);
+        curl_easy_cleanup(curl_handle);
+        curl_global_cleanup();
+        return status;
+    }
+
     // --- Fetch Current Planetary Data for Forecast ---
     printf("\nFetching today's planetary data from NASA...\n");
 
-    time_t t_today = time(NULL);
-    struct tm *tm_info = localtime(&t_today);
-    char today_str[20], tomorrow_str[20];
-    strftime(today_str, sizeof(today_str), "%Y-%m-%d", tm_info);
-    t_today += 24 * 60 * 60;
-    tm_info = localtime(&t_today);
-    strftime(tomorrow_str, sizeof(tomorrow_str), "%Y-%m-%d", tm_info);
-
-    for (int i = 0; i < num_planets; i++) {
-        curl_handle = curl_easy_init();
-        if (curl_handle) {
-            struct MemoryStruct chunk = { .memory = malloc(1), .size = 0 };
-            char url[512];
-            snprintf(url, sizeof(url),
-                     "https://ssd.jpl.nasa.gov/api/horizons.api?format=json&COMMAND='%s'&OBJ_DATA='NO'&MAKE_EPHEM='YES'&EPHEM_TYPE='VECTORS'&CENTER='@399'&START_TIME='%s'&STOP_TIME='%s'&STEP_SIZE='1d'&VEC_TABLE='1'",
-                     planets[i].id, today_str, tomorrow_str);
-
-            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, 0L);
-            curl_easy_setopt(curl_handle, CURLOPT_URL, url);
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
-            if (curl_easy_perform(curl_handle) == CURLE_OK) {
-                parse_planet_data(chunk.memory, &planets[i].longitude);
-            }
-            curl_easy_cleanup(curl_handle);
-            free(chunk.memory);
-        }
+    // Today and tomorrow are both fetched; the second day gives each body's speed.
+    struct PlanetSeries positions;
+    if (planet_series_init(&positions, num_planets, 2) != 0) {
+        printf("Error: Out of memory.\n");
+        curl_easy_cleanup(curl_handle);
+        curl_global_cleanup();
+        return 1;
     }
-    
+    int cached;
+    fetch_positions(curl_handle, body_ids, jd_today_utc(), &positions, &cached);
+    curl_easy_cleanup(curl_handle);
+
     // --- Generate and Display Forecast and Biorhythms ---
-    generate_forecast(planets, num_planets, sun_sign_idx);
-    generate_final_report(planets, num_planets, sun_sign_idx, year, month, day);
+    struct PlanetSlice today = planet_series_day(&positions, 0);
+    struct OutBuf report;
+    outbuf_init(&report);
+    struct Forecast forecast;
+    forecast_compute_sky(&forecast, &today, sun_sign_idx, find_body(planets, num_planets, "Sun"));
+    forecast_compute_biorhythm(&forecast, year, month, day, -1);
+    generate_forecast(&report, planets, &forecast);
+    generate_final_report(&report, &forecast);
+    outbuf_flush(&report, stdout);
+    outbuf_free(&report);
 
+    planet_series_free(&positions);
     curl_global_cleanup();
     return 0;
 }
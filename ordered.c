@@ -0,0 +1,141 @@
+/**
+ * @file ordered.c
+ * @brief Ordered-commit ring and its writer thread; see ordered.h.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ordered.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+struct OrderedSlot {
+    uint64_t ready; // seq + 1 once the slot holds record seq
+    struct OutBuf buf;
+};
+
+struct OrderedWriter {
+    struct OrderedSlot *slots;
+    size_t mask;
+    size_t total;
+    ordered_sink_fn sink;
+    void *sink_ctx;
+    int failed;
+    uint64_t head; // Next sequence number to write; every earlier one is on fd
+    pthread_t thread;
+};
+
+// Backs off while waiting on another thread: yield first, then sleep briefly.
+static void wait_pause(unsigned *spins) {
+    if (++*spins < 64) {
+        sched_yield();
+    } else {
+        struct timespec ts = { 0, 50000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+int ordered_fd_sink(void *ctx, struct iovec *iov, int count) {
+    int fd = *(const int *)ctx;
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
+static void *writer_main(void *arg) {
+    struct OrderedWriter *w = arg;
+    struct iovec iov[IOV_MAX];
+    uint64_t head = 0;
+    unsigned spins = 0;
+
+    while (head < w->total) {
+        // Collect the contiguous run of committed slots starting at head.
+        size_t run = 0;
+        int count = 0;
+        while (head + run < w->total && count < IOV_MAX) {
+            struct OrderedSlot *slot = &w->slots[(head + run) & w->mask];
+            if (__atomic_load_n(&slot->ready, __ATOMIC_ACQUIRE) != head + run + 1) break;
+            if (slot->buf.len) {
+                iov[count].iov_base = slot->buf.data;
+                iov[count].iov_len = slot->buf.len;
+                count++;
+            }
+            run++;
+        }
+        if (run == 0) {
+            wait_pause(&spins);
+            continue;
+        }
+        spins = 0;
+
+        // After a failure keep draining so producers never stall on a full ring.
+        if (!w->failed && w->sink(w->sink_ctx, iov, count) != 0) w->failed = 1;
+        for (size_t i = 0; i < run; i++) w->slots[(head + i) & w->mask].buf.len = 0;
+        head += run;
+        __atomic_store_n(&w->head, head, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+struct OrderedWriter *ordered_writer_start(ordered_sink_fn sink, void *ctx, size_t total, size_t capacity) {
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+
+    struct OrderedWriter *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->slots = calloc(cap, sizeof(*w->slots));
+    w->mask = cap - 1;
+    w->total = total;
+    w->sink = sink;
+    w->sink_ctx = ctx;
+    if (!w->slots || pthread_create(&w->thread, NULL, writer_main, w) != 0) {
+        free(w->slots);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+void ordered_writer_commit(struct OrderedWriter *w, size_t seq, struct OutBuf *buf) {
+    // The slot is free once the writer has moved past its previous occupant.
+    unsigned spins = 0;
+    while (seq - __atomic_load_n(&w->head, __ATOMIC_ACQUIRE) > w->mask) wait_pause(&spins);
+
+    struct OrderedSlot *slot = &w->slots[seq & w->mask];
+    struct OutBuf spare = slot->buf;
+    slot->buf = *buf;
+    *buf = spare;
+    __atomic_store_n(&slot->ready, (uint64_t)seq + 1, __ATOMIC_RELEASE);
+}
+
+int ordered_writer_finish(struct OrderedWriter *w) {
+    pthread_join(w->thread, NULL);
+    int status = w->failed ? -1 : 0;
+    for (size_t i = 0; i <= w->mask; i++) outbuf_free(&w->slots[i].buf);
+    free(w->slots);
+    free(w);
+    return status;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file ordered.h
+ * @brief Reassembles buffers produced out of order into one in-order stream.
+ *
+ * Producers render record number seq into their own OutBuf and commit it;
+ * the buffer lands in a fixed ring slot indexed by seq. A single writer
+ * thread hands the longest contiguous run of committed slots to a sink in
+ * one call (for a descriptor, one writev()), so output order matches input
+ * order without any lock on the output stream. Committing swaps buffers with the slot, which hands the
+ * producer back an emptied buffer from an earlier lap to reuse.
+ *
+ * The ring is lock-free: a slot is published by storing seq + 1 into its
+ * ready word, and the writer publishes its progress through a single head
+ * counter. A producer more than a ring's length ahead of the writer waits,
+ * so producers must claim sequence numbers roughly in order (pool_run_ordered)
+ * with a ring that spans everything in flight; a producer that waits on work
+ * nobody has started would never return.
+ */
+
+#ifndef ORDERED_H
+#define ORDERED_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "outbuf.h"
+
+struct OrderedWriter;
+
+// Consumes count buffers in order; may modify iov. Returns 0 on success, -1 on failure.
+typedef int (*ordered_sink_fn)(void *ctx, struct iovec *iov, int count);
+
+// Sink that writes to the descriptor ctx points to (an int) with writev().
+int ordered_fd_sink(void *ctx, struct iovec *iov, int count);
+
+// Starts a writer thread that will pass sequence numbers 0..total-1 to sink.
+// capacity is rounded up to a power of two. Returns NULL on failure.
+struct OrderedWriter *ordered_writer_start(ordered_sink_fn sink, void *ctx, size_t total, size_t capacity);
+
+// Publishes the text for seq; each seq must be committed exactly once. On
+// return *buf is an empty buffer the caller may keep rendering into.
+void ordered_writer_commit(struct OrderedWriter *w, size_t seq, struct OutBuf *buf);
+
+// Waits until everything has been written, then frees the writer.
+// Returns 0 on success, -1 if the sink failed.
+int ordered_writer_finish(struct OrderedWriter *w);
+
+#endif // ORDERED_H
@@ -0,0 +1,138 @@
+/**
+ * @file outbuf.c
+ * @brief Growable text buffer; see outbuf.h.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "outbuf.h"
+
+void outbuf_init(struct OutBuf *b) {
+    b->data = NULL;
+    b->len = 0;
+    b->cap = 0;
+}
+
+void outbuf_free(struct OutBuf *b) {
+    free(b->data);
+    outbuf_init(b);
+}
+
+int outbuf_reserve(struct OutBuf *b, size_t n) {
+    if (b->len + n + 1 <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + n + 1) cap *= 2;
+    char *grown = realloc(b->data, cap);
+    if (!grown) return -1;
+    b->data = grown;
+    b->cap = cap;
+    return 0;
+}
+
+void outbuf_write(struct OutBuf *b, const char *s, size_t n) {
+    if (outbuf_reserve(b, n) != 0) return;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+void outbuf_puts(struct OutBuf *b, const char *s) {
+    outbuf_write(b, s, strlen(s));
+}
+
+void outbuf_putc(struct OutBuf *b, char c) {
+    outbuf_write(b, &c, 1);
+}
+
+void outbuf_printf(struct OutBuf *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(b->data ? b->data + b->len : NULL, b->data ? b->cap - b->len : 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (b->data && b->len + n < b->cap) {
+        b->len += n;
+        return;
+    }
+
+    // Did not fit: grow and format again.
+    if (outbuf_reserve(b, n) != 0) return;
+    va_start(ap, fmt);
+    vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+    va_end(ap);
+    b->len += n;
+}
+
+// Rounds |value| * 10^decimals to the nearest integer as printf does: from the
+// exact binary value, ties to even. fma() recovers the rounding error of the
+// product, so values just either side of a half (0.015 is 0.01499999...) go the
+// right way. Only valid while the product is below 2^52.
+static unsigned long long round_scaled(double value, double scale) {
+    double product = fabs(value) * scale;
+    double error = fma(fabs(value), scale, -product); // Exact: product + error == |value| * scale
+    double units = rint(product);
+    double frac = product - units; // Exact, and only +-0.5 can be tipped by error
+    if (frac == 0.5 && error > 0) units += 1;
+    if (frac == -0.5 && error < 0) units -= 1;
+    return (unsigned long long)units;
+}
+
+static void put_fixed(struct OutBuf *b, double value, int decimals, int width, int signed_zero) {
+    static const double scale[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+    if (!(fabs(value) * scale[decimals] < 4503599627370496.0)) { // 2^52, or not finite: leave it to stdio
+        outbuf_printf(b, "%*.*f", width, decimals, value);
+        return;
+    }
+
+    // Digits are produced right to left.
+    char digits[32];
+    int pos = sizeof(digits);
+    unsigned long long units = round_scaled(value, scale[decimals]);
+    int negative = signbit(value) && (units != 0 || signed_zero);
+    for (int d = 0; d < decimals; d++) {
+        digits[--pos] = (char)('0' + units % 10);
+        units /= 10;
+    }
+    if (decimals) digits[--pos] = '.';
+    do {
+        digits[--pos] = (char)('0' + units % 10);
+        units /= 10;
+    } while (units);
+    if (negative) digits[--pos] = '-';
+
+    int len = (int)sizeof(digits) - pos;
+    if (outbuf_reserve(b, (size_t)(width > len ? width : len)) != 0) return;
+    for (int pad = width - len; pad > 0; pad--) b->data[b->len++] = ' ';
+    outbuf_write(b, digits + pos, len);
+}
+
+void outbuf_fixed(struct OutBuf *b, double value, int decimals, int width) {
+    put_fixed(b, value, decimals, width, 1);
+}
+
+void outbuf_fixed_unsigned_zero(struct OutBuf *b, double value, int decimals, int width) {
+    put_fixed(b, value, decimals, width, 0);
+}
+
+int outbuf_flush(struct OutBuf *b, FILE *f) {
+    int status = fflush(f) == 0 ? 0 : -1;
+    int fd = fileno(f);
+    size_t done = 0;
+    while (status == 0 && done < b->len) {
+        ssize_t n = write(fd, b->data + done, b->len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) status = -1;
+        else done += n;
+    }
+    b->len = 0;
+    if (b->data) b->data[0] = '\0';
+    return status;
+}
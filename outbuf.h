@@ -0,0 +1,45 @@
+/**
+ * @file outbuf.h
+ * @brief Growable in-memory text buffer that reports are rendered into.
+ *
+ * Rendering into a buffer instead of straight to stdout lets worker threads
+ * produce reports independently and lets the caller decide when and in what
+ * order the bytes reach the output.
+ */
+
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+struct OutBuf {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+void outbuf_init(struct OutBuf *b);
+void outbuf_free(struct OutBuf *b);
+
+// Ensures room for n more bytes plus a terminating NUL. Returns 0 on success, -1 on failure.
+int outbuf_reserve(struct OutBuf *b, size_t n);
+
+void outbuf_write(struct OutBuf *b, const char *s, size_t n);
+void outbuf_puts(struct OutBuf *b, const char *s);
+void outbuf_putc(struct OutBuf *b, char c);
+void outbuf_printf(struct OutBuf *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Appends value rounded to decimals (0-9) places and right-aligned in width
+// columns, digit for digit what printf's "%*.*f" prints, but without the
+// stdio machinery.
+void outbuf_fixed(struct OutBuf *b, double value, int decimals, int width);
+
+// As outbuf_fixed, but a value that rounds to zero is printed without a sign.
+void outbuf_fixed_unsigned_zero(struct OutBuf *b, double value, int decimals, int width);
+
+// Flushes the stream, then hands the whole buffer to its descriptor in one
+// write() and empties the buffer. Returns 0 on success, -1 on failure.
+int outbuf_flush(struct OutBuf *b, FILE *f);
+
+#endif // OUTBUF_H
@@ -0,0 +1,169 @@
+/**
+ * @file pool.c
+ * @brief Work-stealing thread pool; see pool.h.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+// A worker's unclaimed chunks [begin, end), packed as begin << 32 | end.
+struct PoolRange {
+    uint64_t packed;
+    char pad[64 - sizeof(uint64_t)]; // One cache line per worker
+};
+
+struct Pool {
+    struct PoolRange *ranges; // NULL when chunks are dealt in order from next
+    size_t next;
+    size_t num_chunks;
+    int num_threads;
+    pool_task_fn fn;
+    void *ctx;
+};
+
+struct PoolWorker {
+    struct Pool *pool;
+    int index;
+    int started;
+    pthread_t thread;
+};
+
+static inline uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return (uint64_t)begin << 32 | end;
+}
+
+// Claims the first chunk of the worker's own range. Returns 0 when it is empty.
+static int take_own(struct PoolRange *range, uint32_t *chunk) {
+    uint64_t cur = __atomic_load_n(&range->packed, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t begin = (uint32_t)(cur >> 32), end = (uint32_t)cur;
+        if (begin >= end) return 0;
+        if (__atomic_compare_exchange_n(&range->packed, &cur, pack_range(begin + 1, end), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *chunk = begin;
+            return 1;
+        }
+    }
+}
+
+// Moves the back half of a victim's range into the thief's (empty) range.
+static int steal(struct PoolRange *victim, struct PoolRange *thief) {
+    uint64_t cur = __atomic_load_n(&victim->packed, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t begin = (uint32_t)(cur >> 32), end = (uint32_t)cur;
+        if (begin >= end) return 0;
+        uint32_t mid = begin + (end - begin) / 2;
+        if (__atomic_compare_exchange_n(&victim->packed, &cur, pack_range(begin, mid), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            // Chunk indices are handed out once and never return, so a stale
+            // compare-and-swap by another thief cannot match this new value.
+            __atomic_store_n(&thief->packed, pack_range(mid, end), __ATOMIC_RELEASE);
+            return 1;
+        }
+    }
+}
+
+// Claims chunks from the shared cursor, so they start in index order.
+static void run_in_order(struct PoolWorker *w) {
+    struct Pool *pool = w->pool;
+    for (;;) {
+        size_t chunk = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (chunk >= pool->num_chunks) return;
+        pool->fn(pool->ctx, chunk, w->index);
+    }
+}
+
+static void *worker_main(void *arg) {
+    struct PoolWorker *w = arg;
+    struct Pool *pool = w->pool;
+    if (!pool->ranges) {
+        run_in_order(w);
+        return NULL;
+    }
+    struct PoolRange *own = &pool->ranges[w->index];
+
+    for (;;) {
+        uint32_t chunk;
+        while (take_own(own, &chunk)) pool->fn(pool->ctx, chunk, w->index);
+
+        int stolen = 0;
+        for (int i = 1; i < pool->num_threads && !stolen; i++) {
+            stolen = steal(&pool->ranges[(w->index + i) % pool->num_threads], own);
+        }
+        if (!stolen) return NULL; // Every range is empty; remaining chunks are in flight elsewhere
+    }
+}
+
+// Starts the extra workers, works as worker 0 and joins the others.
+static int pool_execute(struct Pool *pool, struct PoolWorker *workers) {
+    int num_threads = pool->num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].pool = pool;
+        workers[i].index = i;
+    }
+
+    // A thread that fails to start leaves its range to be stolen by the others;
+    // in order, it simply never claims a chunk.
+    int started = 1;
+    for (int i = 1; i < num_threads; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) == 0;
+        started += workers[i].started;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i < num_threads; i++) {
+        if (workers[i].started) pthread_join(workers[i].thread, NULL);
+    }
+    return started > 1 || num_threads == 1 ? 0 : -1;
+}
+
+static int clamp_threads(int num_threads, size_t num_chunks) {
+    if (num_threads < 1) num_threads = 1;
+    if ((size_t)num_threads > num_chunks) num_threads = num_chunks ? (int)num_chunks : 1;
+    return num_threads;
+}
+
+int pool_run(int num_threads, size_t num_chunks, pool_task_fn fn, void *ctx) {
+    num_threads = clamp_threads(num_threads, num_chunks);
+    struct Pool pool = { .num_chunks = num_chunks, .num_threads = num_threads, .fn = fn, .ctx = ctx };
+    struct PoolWorker *workers = malloc(num_threads * sizeof(*workers));
+    if (posix_memalign((void **)&pool.ranges, 64, num_threads * sizeof(*pool.ranges)) != 0) pool.ranges = NULL;
+    if (!workers || !pool.ranges) {
+        free(workers);
+        free(pool.ranges);
+        for (size_t c = 0; c < num_chunks; c++) fn(ctx, c, 0);
+        return -1;
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        uint32_t begin = (uint32_t)(num_chunks * i / num_threads);
+        uint32_t end = (uint32_t)(num_chunks * (i + 1) / num_threads);
+        pool.ranges[i].packed = pack_range(begin, end);
+    }
+    int status = pool_execute(&pool, workers);
+    free(workers);
+    free(pool.ranges);
+    return status;
+}
+
+int pool_run_ordered(int num_threads, size_t num_chunks, pool_task_fn fn, void *ctx) {
+    num_threads = clamp_threads(num_threads, num_chunks);
+    struct Pool pool = { .num_chunks = num_chunks, .num_threads = num_threads, .fn = fn, .ctx = ctx };
+    struct PoolWorker *workers = malloc(num_threads * sizeof(*workers));
+    if (!workers) {
+        for (size_t c = 0; c < num_chunks; c++) fn(ctx, c, 0);
+        return -1;
+    }
+    int status = pool_execute(&pool, workers);
+    free(workers);
+    return status;
+}
+
+int pool_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
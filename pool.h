@@ -0,0 +1,41 @@
+/**
+ * @file pool.h
+ * @brief Thread pool for indexed chunks of work, by work stealing or in index order.
+ *
+ * pool_run() is for chunks that may finish in any order. Chunks
+ * 0..num_chunks-1 are first split into one contiguous range per worker. A
+ * worker takes chunks from the front of its own range; once that is empty it
+ * steals the back half of another worker's remaining range. Each range is a
+ * single 64-bit word updated with compare-and-swap, so neither taking nor
+ * stealing needs a lock, and every chunk runs exactly once.
+ *
+ * pool_run_ordered() is for chunks whose output is consumed in index order
+ * while the run is in progress. Stealing would start chunks far ahead of the
+ * consumer, so workers instead claim the next index from one shared atomic
+ * cursor.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Runs one chunk. worker is the calling thread's index in [0, num_threads),
+// for selecting per-thread scratch state.
+typedef void (*pool_task_fn)(void *ctx, size_t chunk, int worker);
+
+// Runs fn for every chunk on num_threads threads (the caller is worker 0) and
+// returns once all chunks are done. Returns 0 on success, -1 if no thread
+// could be started beyond the caller, in which case all work ran on it.
+int pool_run(int num_threads, size_t num_chunks, pool_task_fn fn, void *ctx);
+
+// Like pool_run(), but chunks are claimed one at a time from the shared
+// cursor, so they start in index order and the chunks in flight at any moment
+// are at most num_threads consecutive indices. Use this in front of an
+// ordered writer, whose ring then only needs to span those in-flight chunks.
+int pool_run_ordered(int num_threads, size_t num_chunks, pool_task_fn fn, void *ctx);
+
+// Number of online CPUs, at least 1.
+int pool_default_threads(void);
+
+#endif // POOL_H
@@ -0,0 +1,252 @@
+/**
+ * @file records.c
+ * @brief User record input; see records.h.
+ */
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "records.h"
+
+#define RECORDS_CHUNK_BYTES (1 << 20) // Smallest slice of input worth a task
+#define RECORDS_CHUNKS_PER_THREAD 8   // Slack for the pool to balance uneven lines
+
+// Parses exactly n decimal digits. Returns -1 on a non-digit.
+static int parse_digits(const char *p, int n) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        v = v * 10 + (p[i] - '0');
+    }
+    return v;
+}
+
+// Parses the fixed layout YYYY-MM-DD. Returns 0, or -1 unless all eight
+// positions are digits and both separators are dashes. Calendar validity is
+// left to the caller.
+static int parse_iso_date(const char *p, int *year, int *month, int *day) {
+    if (p[4] != '-' || p[7] != '-') return -1;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Gathers the digits as "YYYYMMDD" in one word and converts all eight at
+    // once (SWAR): byte 0 is the most significant digit.
+    uint64_t w;
+    memcpy((char *)&w, p, 4);
+    memcpy((char *)&w + 4, p + 5, 2);
+    memcpy((char *)&w + 6, p + 8, 2);
+    // Every byte in '0'-'9': high nibble 3 both before and after adding 6.
+    if (((w & 0xF0F0F0F0F0F0F0F0ull) | ((w + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull)) !=
+        0x3030303030303030ull) {
+        return -1;
+    }
+    w -= 0x3030303030303030ull;
+    // Folds digit pairs into bytes 0, 2, 4 and 6: century, year, month, day.
+    w = w * 10 + (w >> 8);
+    *year = (int)(w & 0xFF) * 100 + (int)((w >> 16) & 0xFF);
+    *month = (int)((w >> 32) & 0xFF);
+    *day = (int)((w >> 48) & 0xFF);
+    return 0;
+#else
+    *year = parse_digits(p, 4);
+    *month = parse_digits(p + 5, 2);
+    *day = parse_digits(p + 8, 2);
+    return (*year < 0 || *month < 0 || *day < 0) ? -1 : 0;
+#endif
+}
+
+// Month lengths and the Gregorian leap rule; cheaper than jd_valid_civil's round trip.
+static int valid_date(int year, int month, int day) {
+    static const unsigned char days_in_month[13] = { 0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month[month]) return 0;
+    return month != 2 || day < 29 || (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+}
+
+// Parses one line [line, end). Returns 0 for a record, -1 for a skipped line.
+static int parse_line(const char *line, const char *end, struct UserRecord *rec) {
+    const char *sep = line;
+    while (sep < end && *sep != ',' && *sep != '\t') sep++;
+    if (sep == line || sep == end || *line == '#') return -1;
+
+    const char *date = sep + 1;
+    if (end - date < 10 || parse_iso_date(date, &rec->year, &rec->month, &rec->day) != 0 ||
+        !valid_date(rec->year, rec->month, rec->day)) {
+        return -1;
+    }
+
+    rec->birth_minute = -1;
+    const char *time = date + 10;
+    if (end - time >= 6 && (*time == ',' || *time == '\t' || *time == ' ') && time[3] == ':') {
+        int hour = parse_digits(time + 1, 2), minute = parse_digits(time + 4, 2);
+        if (hour >= 0 && hour < 24 && minute >= 0 && minute < 60) rec->birth_minute = hour * 60 + minute;
+    }
+
+    rec->id = line;
+    rec->id_len = (int)(sep - line);
+    return 0;
+}
+
+// The input split at line starts: chunk c is [start[c], start[c + 1]).
+struct ParseJob {
+    const char *text;
+    size_t *start;
+    size_t *first; // Index of the chunk's first line, once lines are counted
+    size_t *count; // Records (pass 1: lines) in the chunk
+    size_t *skipped;
+    struct UserRecord *records;
+};
+
+static void count_chunk_lines(void *ctx, size_t chunk, int worker) {
+    struct ParseJob *job = ctx;
+    const char *p = job->text + job->start[chunk], *end = job->text + job->start[chunk + 1];
+    size_t lines = 0;
+    (void)worker;
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    // An unterminated last line still counts.
+    job->count[chunk] = lines + (end > job->text + job->start[chunk] && end[-1] != '\n');
+}
+
+// Parses a chunk's lines into its stretch of the record array, from its front.
+static void parse_chunk(void *ctx, size_t chunk, int worker) {
+    struct ParseJob *job = ctx;
+    const char *p = job->text + job->start[chunk], *text_end = job->text + job->start[chunk + 1];
+    struct UserRecord *out = job->records + job->first[chunk];
+    size_t count = 0, skipped = 0;
+    (void)worker;
+    while (p < text_end) {
+        const char *eol = memchr(p, '\n', text_end - p);
+        if (!eol) eol = text_end;
+        const char *end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+        if (end > p) {
+            if (parse_line(p, end, &out[count]) == 0) count++;
+            else skipped++;
+        }
+        p = eol + 1;
+    }
+    job->count[chunk] = count;
+    job->skipped[chunk] = skipped;
+}
+
+// Cuts the input into chunks and parses them into set->records in two pool passes.
+static int parse_chunks(struct RecordSet *set, struct ParseJob *job, size_t size, size_t num_chunks, int num_threads) {
+    // Each cut moves forward to just past the next newline, so no line straddles two chunks.
+    job->start[0] = 0;
+    for (size_t c = 1; c < num_chunks; c++) {
+        size_t cut = size / num_chunks * c;
+        if (cut < job->start[c - 1]) cut = job->start[c - 1];
+        const char *eol = memchr(set->text + cut, '\n', size - cut);
+        job->start[c] = eol ? (size_t)(eol - set->text) + 1 : size;
+    }
+    job->start[num_chunks] = size;
+
+    // Pass 1 sizes every chunk's stretch; pass 2 parses into it.
+    pool_run(num_threads, num_chunks, count_chunk_lines, job);
+    size_t lines = 0;
+    for (size_t c = 0; c < num_chunks; c++) {
+        job->first[c] = lines;
+        lines += job->count[c];
+    }
+    set->records = malloc((lines ? lines : 1) * sizeof(*set->records));
+    if (!set->records) return -1;
+    job->records = set->records;
+    pool_run(num_threads, num_chunks, parse_chunk, job);
+
+    // Close the gaps left by skipped lines, keeping input order.
+    for (size_t c = 0; c < num_chunks; c++) {
+        if (set->count != job->first[c]) {
+            memmove(set->records + set->count, set->records + job->first[c], job->count[c] * sizeof(*set->records));
+        }
+        set->count += job->count[c];
+        set->skipped += job->skipped[c];
+    }
+    return 0;
+}
+
+// Parses set->text[0, size) into set->records.
+static int parse_records(struct RecordSet *set, size_t size, int num_threads) {
+    size_t num_chunks = size / RECORDS_CHUNK_BYTES + 1;
+    size_t max_chunks = (size_t)num_threads * RECORDS_CHUNKS_PER_THREAD;
+    if (num_chunks > max_chunks) num_chunks = max_chunks;
+
+    struct ParseJob job = { .text = set->text };
+    job.start = malloc((num_chunks + 1) * sizeof(size_t));
+    job.first = malloc(num_chunks * sizeof(size_t));
+    job.count = malloc(num_chunks * sizeof(size_t));
+    job.skipped = malloc(num_chunks * sizeof(size_t));
+    int status = -1;
+    if (job.start && job.first && job.count && job.skipped) {
+        status = parse_chunks(set, &job, size, num_chunks, num_threads);
+    }
+    free(job.start);
+    free(job.first);
+    free(job.count);
+    free(job.skipped);
+    return status;
+}
+
+int records_read(FILE *f, struct RecordSet *set, int num_threads) {
+    memset(set, 0, sizeof(*set));
+
+    size_t size = 0, capacity = 1 << 16;
+    set->text = malloc(capacity);
+    if (!set->text) return -1;
+    size_t n;
+    while ((n = fread(set->text + size, 1, capacity - size, f)) > 0) {
+        size += n;
+        if (size == capacity) {
+            char *grown = realloc(set->text, capacity * 2);
+            if (!grown) { records_free(set); return -1; }
+            set->text = grown;
+            capacity *= 2;
+        }
+    }
+    if (ferror(f) || parse_records(set, size, num_threads) != 0) { records_free(set); return -1; }
+    return 0;
+}
+
+int records_load(const char *path, struct RecordSet *set, int num_threads) {
+    if (strcmp(path, "-") == 0) return records_read(stdin, set, num_threads);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        // Empty files, pipes and devices go through stdio.
+        FILE *f = fdopen(fd, "rb");
+        if (!f) { close(fd); return -1; }
+        int status = records_read(f, set, num_threads);
+        fclose(f);
+        return status;
+    }
+    close(fd);
+
+    // Every chunk is read front to back by one thread.
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    memset(set, 0, sizeof(*set));
+    set->text = map;
+    set->mapped = (size_t)st.st_size;
+    if (parse_records(set, set->mapped, num_threads) != 0) {
+        records_free(set);
+        return -1;
+    }
+    return 0;
+}
+
+void records_free(struct RecordSet *set) {
+    free(set->records);
+    if (set->mapped) munmap(set->text, set->mapped);
+    else free(set->text);
+    memset(set, 0, sizeof(*set));
+}
@@ -0,0 +1,46 @@
+/**
+ * @file records.h
+ * @brief Bulk user records (user id, birth date) for batch and population modes.
+ *
+ * Input is one record per line: an id, a comma or tab, and an ISO date
+ * (YYYY-MM-DD), optionally followed by a separator and a birth time (HH:MM).
+ * Blank lines, lines starting with '#' and lines whose date does not parse
+ * (such as a header row) are skipped and counted.
+ *
+ * Regular files are mmap()ed rather than read. The text is cut into
+ * newline-aligned chunks that the thread pool parses in parallel, each
+ * into its own stretch of the record array, so input order is kept.
+ */
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+struct UserRecord {
+    const char *id; // Points into the RecordSet text; not NUL-terminated
+    int id_len;
+    int year, month, day;
+    int birth_minute; // Minutes after midnight, or -1 when no birth time was given
+};
+
+struct RecordSet {
+    struct UserRecord *records;
+    size_t count;
+    size_t skipped;
+    char *text;    // The input that ids point into: a mapping of the file, or an owned copy
+    size_t mapped; // Length of the mapping when text is mmap()ed, else 0
+};
+
+// Reads all records from a stream, parsing on up to num_threads threads.
+// Returns 0 on success, -1 on read or allocation failure.
+int records_read(FILE *f, struct RecordSet *set, int num_threads);
+
+// Maps and parses a file, or reads stdin when path is "-"; pipes and other
+// unmappable inputs are read instead. Returns 0 on success, -1 on failure.
+int records_load(const char *path, struct RecordSet *set, int num_threads);
+
+void records_free(struct RecordSet *set);
+
+#endif // RECORDS_H
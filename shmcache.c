@@ -0,0 +1,186 @@
+/**
+ * @file shmcache.c
+ * @brief Shared-memory cache of decoded positions; see shmcache.h.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "horizons.h"
+#include "shmcache.h"
+
+#define SHMCACHE_MAGIC 0x3153414Eu   // "NAS1"
+#define SHMCACHE_WAIT_SECONDS 120    // Longest wait for a live writer before fetching alone
+#define SHMCACHE_POLL_NS 10000000    // Pause between looks at a segment being written
+#define SHMCACHE_DIR "/dev/shm"      // Where POSIX shared memory objects appear on Linux
+
+struct ShmHeader {
+    uint64_t state; // Writer pid << 32 | sequence number
+    uint32_t magic;
+    int32_t num_bodies;
+    int32_t num_days;
+    int32_t reserved;
+    int64_t first_jdn;
+    char pad[64 - 4 * sizeof(int32_t) - 2 * sizeof(int64_t)];
+};
+
+// Column layout after the header, each column n entries long.
+static size_t segment_size(size_t n) {
+    return sizeof(struct ShmHeader) + n * (sizeof(bam32_t) + 2 * sizeof(float) + sizeof(uint8_t));
+}
+
+// FNV-1a over the body ids, so different body lists never share a segment.
+static uint32_t bodies_hash(const char *const body_ids[], int num_bodies) {
+    uint32_t h = 2166136261u;
+    for (int b = 0; b < num_bodies; b++) {
+        for (const char *p = body_ids[b]; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+        h = (h ^ ',') * 16777619u;
+    }
+    return h;
+}
+
+static void segment_name(char *out, size_t cap, long first_jdn, int num_days, uint32_t hash) {
+    snprintf(out, cap, "/nasa_astro-%u-%ld-%d-%08x", (unsigned)geteuid(), first_jdn, num_days, (unsigned)hash);
+}
+
+// Unlinks this user's segments for windows starting before first_jdn. A
+// process still reading one keeps its mapping; only the name goes.
+static void retire_segments(long first_jdn) {
+    DIR *dir = opendir(SHMCACHE_DIR);
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        unsigned uid;
+        long jdn;
+        int end = 0;
+        if (sscanf(entry->d_name, "nasa_astro-%u-%ld-%*d-%*8x%n", &uid, &jdn, &end) != 2 ||
+            entry->d_name[end] != '\0' || uid != (unsigned)geteuid() || jdn >= first_jdn) {
+            continue;
+        }
+        char name[NAME_MAX + 2];
+        snprintf(name, sizeof(name), "/%s", entry->d_name);
+        shm_unlink(name);
+    }
+    closedir(dir);
+}
+
+static void copy_columns(char *data, const struct PlanetSeries *ps, int to_segment) {
+    size_t n = (size_t)ps->num_bodies * ps->num_days;
+    void *columns[4] = { ps->longitude, ps->latitude, ps->speed, ps->sign };
+    size_t widths[4] = { sizeof(bam32_t), sizeof(float), sizeof(float), sizeof(uint8_t) };
+    for (int c = 0; c < 4; c++) {
+        if (to_segment) memcpy(data, columns[c], n * widths[c]);
+        else memcpy(columns[c], data, n * widths[c]);
+        data += n * widths[c];
+    }
+}
+
+// Copies a populated segment into ps under the seqlock. Returns 0 when the
+// copy is consistent, -1 if a writer intervened or the layout does not match;
+// the caller tells the two apart by whether the state word moved.
+static int segment_read(struct ShmHeader *h, uint64_t state, struct PlanetSeries *ps) {
+    copy_columns((char *)(h + 1), ps, 0);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&h->state, __ATOMIC_RELAXED) != state) return -1;
+    return h->magic == SHMCACHE_MAGIC && h->num_bodies == ps->num_bodies && h->num_days == ps->num_days ? 0 : -1;
+}
+
+// Fetches as the claimed writer and publishes complete results; an
+// incomplete fetch hands the segment back as empty.
+static int segment_populate(struct ShmHeader *h, uint64_t claimed, CURL *curl, const char *const body_ids[],
+                            long first_jdn, struct PlanetSeries *ps) {
+    int fetched = horizons_fetch_series(curl, body_ids, first_jdn, ps);
+    if (fetched != ps->num_bodies) {
+        __atomic_store_n(&h->state, 0, __ATOMIC_RELEASE);
+        return fetched;
+    }
+    h->magic = SHMCACHE_MAGIC;
+    h->num_bodies = ps->num_bodies;
+    h->num_days = ps->num_days;
+    h->first_jdn = first_jdn;
+    copy_columns((char *)(h + 1), ps, 1);
+    __atomic_store_n(&h->state, claimed + 1, __ATOMIC_RELEASE);
+    return fetched;
+}
+
+// True while the process that claimed a segment is still running.
+static int writer_alive(uint64_t state) {
+    pid_t pid = (pid_t)(state >> 32);
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Reads the segment, or claims and populates it. Returns the bodies fetched,
+// or -1 when the segment is unusable or waiting for its writer timed out.
+static int segment_fetch(struct ShmHeader *h, CURL *curl, const char *const body_ids[], long first_jdn,
+                         struct PlanetSeries *ps, int *cached) {
+    uint64_t self = (uint64_t)getpid() << 32;
+    struct timespec start, now, pause = { 0, SHMCACHE_POLL_NS };
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;) {
+        uint64_t state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+        uint32_t seq = (uint32_t)state;
+        if (seq != 0 && seq % 2 == 0) {
+            if (segment_read(h, state, ps) == 0) {
+                *cached = 1;
+                return ps->num_bodies;
+            }
+            // A stable state with the wrong layout is a foreign or damaged segment.
+            if (__atomic_load_n(&h->state, __ATOMIC_ACQUIRE) == state) return -1;
+            continue;
+        }
+
+        // Claim an empty segment, or take over one whose writer has died.
+        uint64_t claim = self | (seq == 0 ? 1 : seq + 2);
+        if ((seq == 0 || !writer_alive(state)) &&
+            __atomic_compare_exchange_n(&h->state, &state, claim, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return segment_populate(h, claim, curl, body_ids, first_jdn, ps);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec - start.tv_sec > SHMCACHE_WAIT_SECONDS) return -1;
+        nanosleep(&pause, NULL);
+    }
+}
+
+int shmcache_fetch_series(CURL *curl, const char *const body_ids[], long first_jdn, struct PlanetSeries *ps,
+                          int *cached) {
+    *cached = 0;
+    char name[64];
+    uint32_t hash = bodies_hash(body_ids, ps->num_bodies);
+    segment_name(name, sizeof(name), first_jdn, ps->num_days, hash);
+    size_t size = segment_size((size_t)ps->num_bodies * ps->num_days);
+
+    // Every process sizes the segment the same way, so racing creators agree.
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    struct stat st;
+    if (fd < 0) return horizons_fetch_series(curl, body_ids, first_jdn, ps);
+    // Another user could create our name first and plant positions in it.
+    if (fstat(fd, &st) != 0 || st.st_uid != geteuid() || (st.st_mode & 077) != 0 ||
+        ((size_t)st.st_size != size && (st.st_size != 0 || ftruncate(fd, size) != 0))) {
+        close(fd);
+        return horizons_fetch_series(curl, body_ids, first_jdn, ps);
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return horizons_fetch_series(curl, body_ids, first_jdn, ps);
+
+    int fetched = segment_fetch(map, curl, body_ids, first_jdn, ps, cached);
+    int published = !*cached && fetched == ps->num_bodies;
+    munmap(map, size);
+    if (fetched < 0) return horizons_fetch_series(curl, body_ids, first_jdn, ps);
+
+    // The writer of a new day retires every earlier day's segments.
+    if (published) retire_segments(first_jdn);
+    return fetched;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file shmcache.h
+ * @brief Decoded daily positions shared between processes through POSIX shared memory.
+ *
+ * Each user and window of days (first date, length and body list) has its
+ * own segment, /nasa_astro-<uid>-<first JDN>-<days>-<body hash>, created
+ * readable and writable by that user only. A segment owned by anyone else,
+ * or open to other users, is never read. Its header carries a seqlock word
+ * that packs a sequence number with the writer's pid:
+ *
+ *   sequence 0     empty; the first process to claim it fetches from Horizons
+ *   odd            being written by the pid in the upper half
+ *   even, above 0  holds complete positions
+ *
+ * A process that finds the window empty claims it with compare-and-swap, so
+ * exactly one process fetches while the others wait, and then copies the
+ * columns in without network access or parsing. Readers validate the copy
+ * against the sequence number, so they never use a torn write. If a writer
+ * dies mid-write, the next process to notice takes over the claim.
+ * Incomplete fetches are never cached.
+ *
+ * A writer that publishes a window removes all of its user's segments for
+ * windows that start on an earlier day, however many days were skipped, so
+ * only the current day's windows stay in shared memory. Callers should
+ * still not cache one-off date ranges, which would each stay until the next
+ * day's publication.
+ */
+
+#ifndef SHMCACHE_H
+#define SHMCACHE_H
+
+#include <curl/curl.h>
+
+#include "ephem.h"
+
+// Fills an initialised series like horizons_fetch_series(): from the shared
+// segment when another process has populated it, otherwise by fetching
+// and then publishing the result. *cached is set to 1 when no request was
+// made. Falls back to a plain fetch when shared memory is unavailable.
+// Returns the number of bodies with positions.
+int shmcache_fetch_series(CURL *curl, const char *const body_ids[], long first_jdn, struct PlanetSeries *ps,
+                          int *cached);
+
+#endif // SHMCACHE_H
@@ -0,0 +1,92 @@
+/**
+ * @file snapshot.c
+ * @brief Epoch-reclaimed snapshot publication; see snapshot.h.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+
+#include "snapshot.h"
+
+// Epoch the reader entered at, or 0 while it is idle.
+struct SnapshotReader {
+    uint64_t epoch;
+    char pad[64 - sizeof(uint64_t)]; // One cache line per reader
+};
+
+void snapshot_init(struct Snapshot *s, void (*destroy)(struct Snapshot *s)) {
+    s->destroy = destroy;
+    s->retired_epoch = 0;
+    s->next_retired = NULL;
+}
+
+void snapshot_release(struct Snapshot *s) {
+    s->destroy(s);
+}
+
+int snapshot_cell_init(struct SnapshotCell *cell, int num_readers, struct Snapshot *initial) {
+    cell->current = initial;
+    cell->epoch = 1;
+    cell->num_readers = num_readers;
+    cell->retired = NULL;
+    if (posix_memalign((void **)&cell->readers, 64, num_readers * sizeof(*cell->readers)) != 0) return -1;
+    for (int i = 0; i < num_readers; i++) cell->readers[i].epoch = 0;
+    return 0;
+}
+
+void snapshot_cell_destroy(struct SnapshotCell *cell) {
+    while (cell->retired) {
+        struct Snapshot *s = cell->retired;
+        cell->retired = s->next_retired;
+        snapshot_release(s);
+    }
+    if (cell->current) snapshot_release(cell->current);
+    free(cell->readers);
+    cell->current = NULL;
+    cell->readers = NULL;
+}
+
+// All four of the marking store, the pointer loads, the exchange and the
+// publisher's slot scan are sequentially consistent. A publisher scan that
+// misses a reader's mark is therefore ordered before that reader's pointer
+// load, which then sees the new snapshot.
+const struct Snapshot *snapshot_enter(struct SnapshotCell *cell, int reader) {
+    uint64_t epoch = __atomic_load_n(&cell->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&cell->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&cell->current, __ATOMIC_SEQ_CST);
+}
+
+void snapshot_leave(struct SnapshotCell *cell, int reader) {
+    __atomic_store_n(&cell->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+void snapshot_publish(struct SnapshotCell *cell, struct Snapshot *next) {
+    struct Snapshot *old = __atomic_exchange_n(&cell->current, next, __ATOMIC_SEQ_CST);
+    // Readers marked with this epoch or later entered after the exchange.
+    old->retired_epoch = __atomic_add_fetch(&cell->epoch, 1, __ATOMIC_SEQ_CST);
+    old->next_retired = cell->retired;
+    cell->retired = old;
+    snapshot_reclaim(cell);
+}
+
+size_t snapshot_reclaim(struct SnapshotCell *cell) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < cell->num_readers; i++) {
+        uint64_t epoch = __atomic_load_n(&cell->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+
+    size_t waiting = 0;
+    struct Snapshot **link = &cell->retired;
+    while (*link) {
+        struct Snapshot *s = *link;
+        if (s->retired_epoch <= oldest) {
+            *link = s->next_retired;
+            snapshot_release(s);
+        } else {
+            waiting++;
+            link = &s->next_retired;
+        }
+    }
+    return waiting;
+}
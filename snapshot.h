@@ -0,0 +1,69 @@
+/**
+ * @file snapshot.h
+ * @brief Lock-free publication of immutable snapshots.
+ *
+ * A SnapshotCell holds the current version of some read-mostly state, such
+ * as a day's positions. Readers never lock: a reader marks its slot with the
+ * global epoch, loads the current pointer and reads the snapshot, then
+ * clears the slot. A snapshot is built completely before it is published
+ * with one atomic exchange, so readers see either the old version or the new
+ * one, never a mix of the two.
+ *
+ * A replaced snapshot is retired with the epoch that followed the exchange.
+ * It is released once every reader slot is either idle or marked with a
+ * later epoch, since such readers can only have loaded the new pointer.
+ * A reader must therefore finish with a snapshot before it leaves.
+ *
+ * Any number of reader threads, each with its own slot index, may run
+ * concurrently with one publishing thread.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Embedded as the first member of a snapshot type.
+struct Snapshot {
+    void (*destroy)(struct Snapshot *s);
+    uint64_t retired_epoch; // Publisher-only bookkeeping from here on
+    struct Snapshot *next_retired;
+};
+
+struct SnapshotReader; // One cache line per reader slot
+
+struct SnapshotCell {
+    struct Snapshot *current;
+    uint64_t epoch; // Starts at 1; a slot value of 0 means idle
+    int num_readers;
+    struct SnapshotReader *readers;
+    struct Snapshot *retired; // Replaced snapshots waiting for their readers
+};
+
+// Starts a snapshot, owned by whoever builds it until it is published.
+void snapshot_init(struct Snapshot *s, void (*destroy)(struct Snapshot *s));
+
+// Destroys a snapshot that was never published, or that no reader can see.
+void snapshot_release(struct Snapshot *s);
+
+// Sets up a cell with reader slots 0..num_readers-1, taking over initial. Returns 0 on success, -1 on allocation failure.
+int snapshot_cell_init(struct SnapshotCell *cell, int num_readers, struct Snapshot *initial);
+
+// Releases the current and all retired snapshots. No reader may be active.
+void snapshot_cell_destroy(struct SnapshotCell *cell);
+
+// Starts a read on a reader slot and returns the current snapshot, which
+// stays valid until snapshot_leave() on the same slot. Never blocks.
+const struct Snapshot *snapshot_enter(struct SnapshotCell *cell, int reader);
+void snapshot_leave(struct SnapshotCell *cell, int reader);
+
+// Publishes next in place of the current snapshot, taking it over from the
+// caller, and retires the old one. Publishers must not run concurrently.
+void snapshot_publish(struct SnapshotCell *cell, struct Snapshot *next);
+
+// Releases retired snapshots that no reader can still see. Call from the
+// publishing thread. Returns how many are still waiting.
+size_t snapshot_reclaim(struct SnapshotCell *cell);
+
+#endif // SNAPSHOT_H
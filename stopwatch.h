@@ -0,0 +1,18 @@
+/**
+ * @file stopwatch.h
+ * @brief Monotonic clock readings for timing work in progress and benchmark reports.
+ */
+
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <time.h>
+
+// Seconds on the monotonic clock; only the difference of two readings means anything.
+static inline double stopwatch_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#endif // STOPWATCH_H
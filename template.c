@@ -0,0 +1,306 @@
+/**
+ * @file template.c
+ * @brief Template compilation, packs and rendering; see template.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "template.h"
+
+static const struct { const char *name; enum TemplateSlot slot; } slot_names[] = {
+    { "sign", SLOT_SIGN },
+    { "planet", SLOT_PLANET },
+    { "keyword", SLOT_KEYWORD },
+    { "house", SLOT_HOUSE },
+    { "ordinal", SLOT_ORDINAL },
+    { "house_keyword", SLOT_HOUSE_KEYWORD },
+};
+
+static void template_free(struct Template *t) {
+    free(t->text);
+    free(t->segments);
+}
+
+static int add_segment(struct Template *t, int *capacity, enum TemplateSlot slot, size_t offset, size_t len) {
+    if (slot == SLOT_LITERAL && len == 0) return 0;
+    if (t->num_segments == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        struct TemplateSegment *grown = realloc(t->segments, *capacity * sizeof(*grown));
+        if (!grown) return -1;
+        t->segments = grown;
+    }
+    t->segments[t->num_segments].slot = (uint8_t)slot;
+    t->segments[t->num_segments].offset = (uint32_t)offset;
+    t->segments[t->num_segments].len = (uint32_t)len;
+    t->num_segments++;
+    if (slot == SLOT_LITERAL) t->literal_len += len;
+    return 0;
+}
+
+// Splits text into literal runs and slots. Returns 0 on success, -1 on error.
+static int split_segments(struct Template *t, const char *text) {
+    int capacity = 0;
+    size_t len = 0, run = 0; // Output length and start of the current literal run
+    for (const char *p = text; *p; p++) {
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            t->text[len++] = *p++;
+            continue;
+        }
+        if (*p == '}') return -1;
+        if (*p != '{') {
+            t->text[len++] = *p;
+            continue;
+        }
+
+        const char *close = strchr(p, '}');
+        if (!close) return -1;
+        size_t name_len = close - p - 1;
+        int slot = -1;
+        for (size_t i = 0; i < sizeof(slot_names) / sizeof(slot_names[0]); i++) {
+            if (strlen(slot_names[i].name) == name_len && strncmp(slot_names[i].name, p + 1, name_len) == 0) {
+                slot = slot_names[i].slot;
+            }
+        }
+        if (slot < 0) return -1;
+        if (add_segment(t, &capacity, SLOT_LITERAL, run, len - run) != 0) return -1;
+        if (add_segment(t, &capacity, slot, 0, 0) != 0) return -1;
+        run = len;
+        p = close;
+    }
+    t->text[len] = '\0';
+    return add_segment(t, &capacity, SLOT_LITERAL, run, len - run);
+}
+
+static int template_compile(struct Template *t, const char *text) {
+    memset(t, 0, sizeof(*t));
+    t->text = malloc(strlen(text) + 1);
+    if (!t->text || split_segments(t, text) != 0) {
+        template_free(t);
+        return -1;
+    }
+    return 0;
+}
+
+void template_pack_init(struct TemplatePack *pack) {
+    pack->count = 0;
+    pack->keys = NULL;
+    pack->templates = NULL;
+}
+
+void template_pack_free(struct TemplatePack *pack) {
+    for (int i = 0; i < pack->count; i++) {
+        free(pack->keys[i]);
+        template_free(&pack->templates[i]);
+    }
+    free(pack->keys);
+    free(pack->templates);
+    template_pack_init(pack);
+}
+
+int template_pack_set(struct TemplatePack *pack, const char *key, const char *text) {
+    struct Template t;
+    if (template_compile(&t, text) != 0) return -1;
+
+    for (int i = 0; i < pack->count; i++) {
+        if (strcmp(pack->keys[i], key) == 0) {
+            template_free(&pack->templates[i]);
+            pack->templates[i] = t;
+            return 0;
+        }
+    }
+
+    char **keys = realloc(pack->keys, (pack->count + 1) * sizeof(*keys));
+    if (keys) pack->keys = keys;
+    struct Template *templates = realloc(pack->templates, (pack->count + 1) * sizeof(*templates));
+    if (templates) pack->templates = templates;
+    char *key_copy = malloc(strlen(key) + 1);
+    if (!keys || !templates || !key_copy) {
+        free(key_copy);
+        template_free(&t);
+        return -1;
+    }
+    strcpy(key_copy, key);
+    pack->keys[pack->count] = key_copy;
+    pack->templates[pack->count] = t;
+    pack->count++;
+    return 0;
+}
+
+int template_pack_copy(struct TemplatePack *dst, const struct TemplatePack *src) {
+    template_pack_init(dst);
+    dst->keys = calloc(src->count ? src->count : 1, sizeof(*dst->keys));
+    dst->templates = calloc(src->count ? src->count : 1, sizeof(*dst->templates));
+    if (!dst->keys || !dst->templates) {
+        template_pack_free(dst);
+        return -1;
+    }
+    for (int i = 0; i < src->count; i++) {
+        const struct Template *from = &src->templates[i];
+        struct Template *to = &dst->templates[i];
+        size_t text_size = strlen(from->text) + 1;
+        *to = *from;
+        to->text = malloc(text_size);
+        to->segments = malloc((from->num_segments ? from->num_segments : 1) * sizeof(*to->segments));
+        dst->keys[i] = malloc(strlen(src->keys[i]) + 1);
+        dst->count++;
+        if (!to->text || !to->segments || !dst->keys[i]) {
+            template_pack_free(dst);
+            return -1;
+        }
+        memcpy(to->text, from->text, text_size);
+        memcpy(to->segments, from->segments, from->num_segments * sizeof(*to->segments));
+        strcpy(dst->keys[i], src->keys[i]);
+    }
+    return 0;
+}
+
+// Resolves backslash escapes in place. Returns -1 on an unknown escape.
+static int unescape(char *s) {
+    char *out = s;
+    for (char *p = s; *p; p++) {
+        if (*p != '\\') {
+            *out++ = *p;
+            continue;
+        }
+        switch (*++p) {
+        case 'n': *out++ = '\n'; break;
+        case 't': *out++ = '\t'; break;
+        case 'e': *out++ = '\x1b'; break;
+        case '\\': *out++ = '\\'; break;
+        default: return -1;
+        }
+    }
+    *out = '\0';
+    return 0;
+}
+
+// Parses one "key = value" line into the pack. Returns 0 on success, -1 on error.
+static int load_line(struct TemplatePack *pack, char *key) {
+    char *eq = strchr(key, '=');
+    if (!eq || eq == key) return -1;
+    char *key_end = eq;
+    while (key_end > key && (key_end[-1] == ' ' || key_end[-1] == '\t')) key_end--;
+    *key_end = '\0';
+
+    char *value = eq + 1;
+    while (*value == ' ' || *value == '\t') value++;
+    if (unescape(value) != 0) return -1;
+    return template_pack_set(pack, key, value);
+}
+
+int template_pack_load(struct TemplatePack *pack, const char *path, int *error_line) {
+    *error_line = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char line[4096];
+    int status = 0;
+    for (int line_no = 1; fgets(line, sizeof(line), f); line_no++) {
+        size_t n = strlen(line);
+        int too_long = n == sizeof(line) - 1 && line[n - 1] != '\n';
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+
+        char *key = line;
+        while (*key == ' ' || *key == '\t') key++;
+        if (!too_long && (*key == '\0' || *key == '#')) continue;
+        if (too_long || load_line(pack, key) != 0) {
+            *error_line = line_no;
+            status = -1;
+            break;
+        }
+    }
+    if (ferror(f)) status = -1;
+    fclose(f);
+    return status;
+}
+
+// Copies n bytes from src to dst without ANSI escapes; dst may equal src.
+// CSI sequences (ESC [ parameters final-byte) go whole, other escapes take
+// the one character after ESC. Returns the bytes written.
+static size_t copy_without_ansi(char *dst, const char *src, size_t n) {
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (src[i] != '\x1b') {
+            dst[len++] = src[i];
+            continue;
+        }
+        if (i + 1 < n && src[i + 1] == '[') {
+            i += 2;
+            while (i < n && !(src[i] >= 0x40 && src[i] <= 0x7E)) i++;
+        } else {
+            i++;
+        }
+    }
+    return len;
+}
+
+void template_pack_strip_ansi(struct TemplatePack *pack) {
+    for (int i = 0; i < pack->count; i++) {
+        // The literal runs are stored back to back in text, so compacting them
+        // in order only ever moves bytes towards the front.
+        struct Template *t = &pack->templates[i];
+        size_t len = 0;
+        t->literal_len = 0;
+        for (int s = 0; s < t->num_segments; s++) {
+            struct TemplateSegment *seg = &t->segments[s];
+            if (seg->slot != SLOT_LITERAL) continue;
+            size_t n = copy_without_ansi(t->text + len, t->text + seg->offset, seg->len);
+            seg->offset = (uint32_t)len;
+            seg->len = (uint32_t)n;
+            t->literal_len += n;
+            len += n;
+        }
+        t->text[len] = '\0';
+    }
+}
+
+const struct Template *template_pack_find(const struct TemplatePack *pack, const char *key) {
+    for (int i = 0; i < pack->count; i++) {
+        if (strcmp(pack->keys[i], key) == 0) return &pack->templates[i];
+    }
+    return NULL;
+}
+
+const char *template_literal(const struct Template *t) {
+    for (int i = 0; i < t->num_segments; i++) {
+        if (t->segments[i].slot != SLOT_LITERAL) return NULL;
+    }
+    return t->text;
+}
+
+static void put_string(struct OutBuf *out, const char *s) {
+    if (s) outbuf_write(out, s, strlen(s));
+}
+
+void template_render(struct OutBuf *out, const struct Template *t, const struct TemplateArgs *args) {
+    // One reservation covers the literal text and typical slot values.
+    outbuf_reserve(out, t->literal_len + 64 * (size_t)t->num_segments);
+    for (int i = 0; i < t->num_segments; i++) {
+        const struct TemplateSegment *seg = &t->segments[i];
+        switch ((enum TemplateSlot)seg->slot) {
+        case SLOT_LITERAL:
+            outbuf_write(out, t->text + seg->offset, seg->len);
+            break;
+        case SLOT_SIGN:
+            put_string(out, args->sign);
+            break;
+        case SLOT_PLANET:
+            put_string(out, args->planet);
+            break;
+        case SLOT_KEYWORD:
+            put_string(out, args->keyword);
+            break;
+        case SLOT_HOUSE_KEYWORD:
+            put_string(out, args->house_keyword);
+            break;
+        case SLOT_HOUSE:
+            outbuf_fixed(out, args->house, 0, 0);
+            break;
+        case SLOT_ORDINAL:
+            put_string(out, args->house == 1 ? "st" : args->house == 2 ? "nd" : args->house == 3 ? "rd" : "th");
+            break;
+        }
+    }
+}
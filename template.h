@@ -0,0 +1,92 @@
+/**
+ * @file template.h
+ * @brief Sentence templates compiled to literal segments and typed slots.
+ *
+ * A template is text with named slots, e.g.
+ *   "- {planet} is transiting your {house}{ordinal} House of {house_keyword}.\n"
+ * Compiling splits it once into literal runs and slot references, so
+ * rendering is a linear sequence of copies into an OutBuf with no parsing or
+ * printf. "{{" and "}}" stand for literal braces.
+ *
+ * Templates live in a pack keyed by name. A pack starts from built-in
+ * defaults and can be overlaid from a file of "key = value" lines, which lets
+ * operators reword or translate reports without recompiling. In the file,
+ * everything after "=" and any following spaces is the value, trailing
+ * spaces included; \n, \t, \e (ESC) and \\ are escapes, and lines starting
+ * with # are comments.
+ */
+
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "outbuf.h"
+
+enum TemplateSlot {
+    SLOT_LITERAL,       // Not a slot: a run of the template's own text
+    SLOT_SIGN,          // {sign}
+    SLOT_PLANET,        // {planet}
+    SLOT_KEYWORD,       // {keyword}: what the planet governs
+    SLOT_HOUSE,         // {house}: number 1-12
+    SLOT_ORDINAL,       // {ordinal}: "st", "nd", "rd" or "th" for {house}
+    SLOT_HOUSE_KEYWORD  // {house_keyword}: what the house governs
+};
+
+// Values for the slots of one rendering; unused fields may be left NULL/0.
+struct TemplateArgs {
+    const char *sign;
+    const char *planet;
+    const char *keyword;
+    const char *house_keyword;
+    int house;
+};
+
+struct TemplateSegment {
+    uint8_t slot;    // enum TemplateSlot
+    uint32_t offset; // SLOT_LITERAL: the run's position in text
+    uint32_t len;
+};
+
+struct Template {
+    char *text;      // Template text with brace escapes resolved; the literal runs point into it
+    size_t literal_len;
+    int num_segments;
+    struct TemplateSegment *segments;
+};
+
+struct TemplatePack {
+    int count;
+    char **keys;
+    struct Template *templates;
+};
+
+void template_pack_init(struct TemplatePack *pack);
+void template_pack_free(struct TemplatePack *pack);
+
+// Compiles text and stores it under key, replacing any earlier template.
+// Returns 0 on success, -1 for a malformed template or allocation failure.
+int template_pack_set(struct TemplatePack *pack, const char *key, const char *text);
+
+// Fills dst with an independent copy of src. Returns 0 on success, -1 on allocation failure.
+int template_pack_copy(struct TemplatePack *dst, const struct TemplatePack *src);
+
+// Overlays templates from a file. Returns 0 on success; on failure returns -1
+// with *error_line set to the offending line, or 0 if the file was unreadable.
+int template_pack_load(struct TemplatePack *pack, const char *path, int *error_line);
+
+// Removes ANSI terminal escape sequences (such as colors written with \e)
+// from every template in the pack, for output that is not a terminal.
+void template_pack_strip_ansi(struct TemplatePack *pack);
+
+// Returns the template stored under key, or NULL.
+const struct Template *template_pack_find(const struct TemplatePack *pack, const char *key);
+
+// Returns the text of a template without slots, or NULL if it has any.
+const char *template_literal(const struct Template *t);
+
+// Appends the template with its slots filled in.
+void template_render(struct OutBuf *out, const struct Template *t, const struct TemplateArgs *args);
+
+#endif // TEMPLATE_H